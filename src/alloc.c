@@ -556,6 +556,7 @@ free_all_mem(void)
 
     free_termoptions();
     free_cur_term();
+    free_out_buf();
 
     // screenlines (can't display anything now!)
     free_screenlines();
@@ -18,6 +18,7 @@
 #endif
 
 #define SMALLBUFSIZE	256	// size of emergency write buffer
+#define BIGBUFSIZE	0x10000L // size of buffer for writing the text
 
 /*
  * Structure to pass arguments from buf_write() to buf_write_bytes().
@@ -45,6 +46,23 @@ struct bw_info
 #endif
 };
 
+/*
+ * Structure used by buf_write() to check for an interrupt and show progress
+ * while writing the text.
+ */
+struct bw_progress
+{
+    buf_T	*bp_buf;	// buffer being written
+    char_u	*bp_fname;	// file name used in the message
+    linenr_T	bp_start;	// first line to write
+    linenr_T	bp_end;		// last line to write
+    int		bp_show;	// show the progress
+#ifdef ELAPSED_FUNC
+    elapsed_T	bp_start_tv;	// when writing the text started
+    long	bp_next_msec;	// when to show progress next
+#endif
+};
+
 /*
  * Convert a Unicode character to bytes.
  * Return TRUE for an error, FALSE when it's OK.
@@ -613,6 +631,34 @@ new_file_message(void)
     return shortmess(SHM_NEW) ? _("[New]") : _("[New File]");
 }
 
+/*
+ * Called after a block of text was written, up to line "lnum".  Checks for an
+ * interrupt and shows the percentage of lines written about once per second,
+ * the user can see Vim is still busy and may interrupt.
+ * Returns TRUE when interrupted.
+ */
+    static int
+write_block_done(struct bw_progress *bp, linenr_T lnum)
+{
+    ui_breakcheck();
+    if (got_int)
+	return TRUE;
+#ifdef ELAPSED_FUNC
+    if (bp->bp_show && ELAPSED_FUNC(bp->bp_start_tv) >= bp->bp_next_msec)
+    {
+	char_u	msgbuf[20];
+
+	vim_snprintf((char *)msgbuf, sizeof(msgbuf), " %d%%",
+		(int)((varnumber_T)(lnum - bp->bp_start + 1) * 100
+				/ (varnumber_T)(bp->bp_end - bp->bp_start + 1)));
+	filemess(bp->bp_buf, bp->bp_fname, msgbuf, 0);
+	out_flush();
+	bp->bp_next_msec = ELAPSED_FUNC(bp->bp_start_tv) + 1000;
+    }
+#endif
+    return FALSE;
+}
+
 /*
  * buf_write() - write to file "fname" lines "start" through "end"
  *
@@ -653,6 +699,9 @@ buf_write(
     char_u	    *ptr;
     char_u	    c;
     int		    len;
+    int		    linelen;
+    int		    n;
+    struct bw_progress progress;
     linenr_T	    lnum;
     long	    nchars;
     char_u	    *errmsg = NULL;
@@ -1029,7 +1078,8 @@ buf_write(
 		    (char_u *)"", 0);	// show that we are busy
     msg_scroll = FALSE;		    // always overwrite the file message now
 
-    buffer = alloc(WRITEBUFSIZE);
+    // Use a big buffer to reduce the number of write() calls.
+    buffer = alloc(BIGBUFSIZE);
     if (buffer == NULL)		    // can't allocate big buffer, use small
 				    // one (to be able to write when out of
 				    // memory)
@@ -1038,7 +1088,7 @@ buf_write(
 	bufsize = SMALLBUFSIZE;
     }
     else
-	bufsize = WRITEBUFSIZE;
+	bufsize = BIGBUFSIZE;
 
     // Get information about original file (if there is one).
 #if defined(UNIX)
@@ -2039,36 +2089,52 @@ restore_backup:
 	write_info.bw_len = bufsize;
 	write_info.bw_flags = wb_flags;
 	fileformat = get_fileformat_force(buf, eap);
+	progress.bp_buf = buf;
+#ifndef UNIX
+	progress.bp_fname = sfname;
+#else
+	progress.bp_fname = fname;
+#endif
+	progress.bp_start = start;
+	progress.bp_end = end;
+	progress.bp_show = !filtering;
+#ifdef ELAPSED_FUNC
+	ELAPSED_INIT(progress.bp_start_tv);
+	progress.bp_next_msec = 1000;
+#endif
 	s = buffer;
 	len = 0;
 	for (lnum = start; lnum <= end; ++lnum)
 	{
-	    // The next while loop is done once for each character written.
-	    // Keep it fast!
-	    ptr = ml_get_buf(buf, lnum, FALSE) - 1;
+	    ptr = ml_get_buf(buf, lnum, FALSE);
+	    linelen = ml_get_buf_len(buf, lnum);
 #ifdef FEAT_PERSISTENT_UNDO
 	    if (write_undo_file)
-		sha256_update(&sha_ctx, ptr + 1,
-					      (UINT32_T)(STRLEN(ptr + 1) + 1));
+		sha256_update(&sha_ctx, ptr, (UINT32_T)(linelen + 1));
 #endif
-	    while ((c = *++ptr) != NUL)
+	    // The text is copied in pieces that fit in the buffer.  The next
+	    // while loop is done once for each piece.  Keep it fast!
+	    while (linelen > 0)
 	    {
-		if (c == NL)
-		    *s = NUL;		// replace newlines with NULs
-		else if (c == CAR && fileformat == EOL_MAC)
-		    *s = NL;		// Mac: replace CRs with NLs
-		else
-		    *s = c;
-		++s;
-		if (++len != bufsize)
+		char_u	*p;
+
+		n = MIN(linelen, bufsize - len);
+		mch_memmove(s, ptr, (size_t)n);
+		// replace newlines with NULs
+		for (p = memchr(s, NL, (size_t)n); p != NULL;
+				 p = memchr(p + 1, NL, (size_t)(s + n - p - 1)))
+		    *p = NUL;
+		if (fileformat == EOL_MAC)
+		    // Mac: replace CRs with NLs
+		    for (p = memchr(s, CAR, (size_t)n); p != NULL;
+				p = memchr(p + 1, CAR, (size_t)(s + n - p - 1)))
+			*p = NL;
+		s += n;
+		ptr += n;
+		linelen -= n;
+		len += n;
+		if (len != bufsize)
 		    continue;
-#ifdef FEAT_CRYPT
-		if (write_info.bw_fd > 0 && lnum == end
-			&& (write_info.bw_flags & FIO_ENCRYPTED)
-			&& *buf->b_p_key != NUL && !filtering
-			&& *ptr == NUL)
-		    write_info.bw_finish = TRUE;
-#endif
 		if (buf_write_bytes(&write_info) == FAIL)
 		{
 		    end = 0;		// write error: break loop
@@ -2078,6 +2144,11 @@ restore_backup:
 		s = buffer;
 		len = 0;
 		write_info.bw_start_lnum = lnum;
+		if (write_block_done(&progress, lnum))
+		{
+		    end = 0;		// Interrupted, break loop
+		    break;
+		}
 	    }
 	    // write failed or last line has no EOL: stop here
 	    if (end == 0
@@ -2108,6 +2179,11 @@ restore_backup:
 			nchars += bufsize;
 			s = buffer;
 			len = 0;
+			if (write_block_done(&progress, lnum))
+			{
+			    end = 0;	// Interrupted, break loop
+			    break;
+			}
 		    }
 		    *s++ = NL;
 		}
@@ -2123,8 +2199,7 @@ restore_backup:
 		s = buffer;
 		len = 0;
 
-		ui_breakcheck();
-		if (got_int)
+		if (write_block_done(&progress, lnum))
 		{
 		    end = 0;		// Interrupted, break loop
 		    break;
@@ -632,6 +632,7 @@ diff_check_unchanged(tabpage_T *tp, diff_T *dp)
     int		i_new;
     int		off_org, off_new;
     char_u	*line_org;
+    linepin_T	pin_org;
     int		dir = FORWARD;
 
     // Find the first buffers, use it as the original, compare the other
@@ -654,11 +655,11 @@ diff_check_unchanged(tabpage_T *tp, diff_T *dp)
 	// lines has become zero.
 	while (dp->df_count[i_org] > 0)
 	{
-	    // Copy the line, the next ml_get() will invalidate it.
+	    // Pin the line, the next ml_get() may invalidate it.
 	    if (dir == BACKWARD)
 		off_org = dp->df_count[i_org] - 1;
-	    line_org = vim_strsave(ml_get_buf(tp->tp_diffbuf[i_org],
-					dp->df_lnum[i_org] + off_org, FALSE));
+	    line_org = ml_pin_line(tp->tp_diffbuf[i_org],
+				  dp->df_lnum[i_org] + off_org, &pin_org);
 	    if (line_org == NULL)
 		return;
 	    for (i_new = i_org + 1; i_new < DB_COUNT; ++i_new)
@@ -674,7 +675,7 @@ diff_check_unchanged(tabpage_T *tp, diff_T *dp)
 				   dp->df_lnum[i_new] + off_new, FALSE)) != 0)
 		    break;
 	    }
-	    vim_free(line_org);
+	    ml_unpin_line(&pin_org);
 
 	    // Stop when a line isn't equal in all diff buffers.
 	    if (i_new != DB_COUNT)
@@ -2574,6 +2575,7 @@ diff_equal_entry(diff_T *dp, int idx1, int idx2)
 {
     int		i;
     char_u	*line;
+    linepin_T	pin;
     int		cmp;
 
     if (dp->df_count[idx1] != dp->df_count[idx2])
@@ -2582,13 +2584,13 @@ diff_equal_entry(diff_T *dp, int idx1, int idx2)
 	return FALSE;
     for (i = 0; i < dp->df_count[idx1]; ++i)
     {
-	line = vim_strsave(ml_get_buf(curtab->tp_diffbuf[idx1],
-					       dp->df_lnum[idx1] + i, FALSE));
+	line = ml_pin_line(curtab->tp_diffbuf[idx1],
+					       dp->df_lnum[idx1] + i, &pin);
 	if (line == NULL)
 	    return FALSE;
 	cmp = diff_cmp(line, ml_get_buf(curtab->tp_diffbuf[idx2],
 					       dp->df_lnum[idx2] + i, FALSE));
-	vim_free(line);
+	ml_unpin_line(&pin);
 	if (cmp != 0)
 	    return FALSE;
     }
@@ -3198,6 +3200,7 @@ diff_find_change_simple(
     int		*endp)		// last char of the change
 {
     char_u	*line_org;
+    linepin_T	pin_org;
     char_u	*line_new;
     int		i;
     int		si_org, si_new;
@@ -3211,11 +3214,13 @@ diff_find_change_simple(
     {
 	// We only care about the return value, not the actual string comparisons.
 	line_org = NULL;
+	pin_org.lp_hp = NULL;
+	pin_org.lp_alloc = NULL;
     }
     else
     {
-	// Make a copy of the line, the next ml_get() will invalidate it.
-	line_org = vim_strsave(ml_get_buf(wp->w_buffer, lnum, FALSE));
+	// Pin the line, the next ml_get() may invalidate it.
+	line_org = ml_pin_line(wp->w_buffer, lnum, &pin_org);
 	if (line_org == NULL)
 	    return FALSE;
     }
@@ -3307,7 +3312,7 @@ diff_find_change_simple(
 	    }
 	}
 
-    vim_free(line_org);
+    ml_unpin_line(&pin_org);
     return added;
 }
 
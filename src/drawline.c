@@ -1210,6 +1210,9 @@ win_line(
     int		prev_syntax_attr = 0;	// syntax_attr at prev_syntax_col
     int		has_syntax = FALSE;	// this buffer has syntax highl.
     int		save_did_emsg;
+# ifdef FEAT_PROFILE
+    proftime_T	syn_tm;			// for ":redrawstats"
+# endif
 #endif
 #ifdef FEAT_PROP_POPUP
 # define WIN_LINE_TEXT_PROP_STACK_LEN 32
@@ -1354,7 +1357,15 @@ win_line(
 	    // error, stop syntax highlighting.
 	    save_did_emsg = did_emsg;
 	    did_emsg = FALSE;
+# ifdef FEAT_PROFILE
+	    if (redrawstats_on)
+		profile_start(&syn_tm);
+# endif
 	    syntax_start(wp, lnum);
+# ifdef FEAT_PROFILE
+	    if (redrawstats_on)
+		redrawstats_add_time(&redrawstats.rs_syn_time, &syn_tm);
+# endif
 	    if (did_emsg)
 		wp->w_s->b_syn_error = TRUE;
 	    else
@@ -1958,7 +1969,17 @@ win_line(
 # ifdef FEAT_SYN_HL
 	    // Need to restart syntax highlighting for this line.
 	    if (has_syntax)
+	    {
+#  ifdef FEAT_PROFILE
+		if (redrawstats_on)
+		    profile_start(&syn_tm);
+#  endif
 		syntax_start(wp, lnum);
+#  ifdef FEAT_PROFILE
+		if (redrawstats_on)
+		    redrawstats_add_time(&redrawstats.rs_syn_time, &syn_tm);
+#  endif
+	    }
 # endif
 	}
 #endif
@@ -2608,12 +2629,21 @@ win_line(
 		    {
 # ifdef FEAT_SPELL
 			can_spell = TRUE;
+# endif
+# ifdef FEAT_PROFILE
+			if (redrawstats_on)
+			    profile_start(&syn_tm);
 # endif
 			syntax_attr = get_syntax_attr((colnr_T)v,
 # ifdef FEAT_SPELL
 					    spv->spv_has_spell ? &can_spell :
 # endif
 					    NULL, FALSE);
+# ifdef FEAT_PROFILE
+			if (redrawstats_on)
+			    redrawstats_add_time(&redrawstats.rs_syn_time,
+								     &syn_tm);
+# endif
 			prev_syntax_col = v;
 			prev_syntax_attr = syntax_attr;
 		    }
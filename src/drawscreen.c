@@ -73,6 +73,9 @@ static void redraw_custom_statusline(win_T *wp);
 static int  did_update_one_window;
 #endif
 
+#ifdef FEAT_PROFILE
+static void redrawstats_win_time(win_T *wp, proftime_T *tm);
+#endif
 #ifdef FEAT_EVAL
 static void redraw_listener_cleanup(void);
 static void invoke_redraw_listener_start_or_end(bool start);
@@ -101,6 +104,13 @@ update_screen(int type_arg)
     int		did_redraw_window = FALSE;
 #endif
     bool	override_success;
+#ifdef FEAT_PROFILE
+    int		rs_timing = FALSE;
+    proftime_T	rs_tm;
+# ifdef FEAT_PROP_POPUP
+    proftime_T	rs_popup_tm;
+# endif
+#endif
 
     // Don't do anything if the screen structures are (not yet) valid.
     if (!screen_valid(TRUE))
@@ -160,8 +170,18 @@ update_screen(int type_arg)
     }
     updating_screen = TRUE;
 
+    out_frame_start();
     term_set_sync_output(TERM_SYNC_OUTPUT_ENABLE);
 
+#ifdef FEAT_PROFILE
+    if (redrawstats_on)
+    {
+	rs_timing = TRUE;
+	++redrawstats.rs_updates;
+	profile_start(&rs_tm);
+    }
+#endif
+
 #ifdef FEAT_PROP_POPUP
     // Update popup_mask if needed.  This may set w_redraw_top and w_redraw_bot
     // in some windows.
@@ -237,6 +257,10 @@ update_screen(int type_arg)
 
     if (type == UPD_CLEAR)		// first clear screen
     {
+#ifdef FEAT_PROFILE
+	if (rs_timing)
+	    ++redrawstats.rs_clear;
+#endif
 	screenclear();		// will reset clear_cmdline
 	type = UPD_NOT_VALID;
 	// must_redraw may be set indirectly, avoid another redraw later
@@ -379,7 +403,20 @@ update_screen(int type_arg)
 #ifdef FEAT_PROP_POPUP
     // Display popup windows on top of the windows and command line.
     if (did_redraw_window || popup_need_redraw())
+    {
+# ifdef FEAT_PROFILE
+	if (rs_timing)
+	    profile_start(&rs_popup_tm);
+# endif
 	update_popups(win_update);
+# ifdef FEAT_PROFILE
+	if (rs_timing)
+	{
+	    profile_end(&rs_popup_tm);
+	    profile_add(&redrawstats.rs_popup_time, &rs_popup_tm);
+	}
+# endif
+    }
 #endif
 
 #ifdef FEAT_TERMINAL
@@ -436,7 +473,16 @@ update_screen(int type_arg)
     redraw_listener_cleanup();
 #endif
 
+#ifdef FEAT_PROFILE
+    if (rs_timing)
+    {
+	profile_end(&rs_tm);
+	profile_add(&redrawstats.rs_time, &rs_tm);
+    }
+#endif
+
     term_set_sync_output(TERM_SYNC_OUTPUT_DISABLE);
+    out_frame_end();
 
     return OK;
 }
@@ -1529,6 +1575,11 @@ win_update(win_T *wp)
     int		save_got_int;
 #endif
     bool	override_success;
+#ifdef FEAT_PROFILE
+    // When called recursively the time is included in the outer call.
+    int		rs_timing = redrawstats_on && !recursive;
+    proftime_T	rs_tm;
+#endif
 
 #if defined(FEAT_SEARCH_EXTRA) || defined(FEAT_CLIPBOARD)
     // This needs to be done only for the first window when update_screen() is
@@ -1580,6 +1631,19 @@ win_update(win_T *wp)
 
     override_success = push_highlight_overrides(wp->w_hl, wp->w_hl_len);
 
+#ifdef FEAT_PROFILE
+    if (rs_timing)
+    {
+	++redrawstats.rs_win_updates;
+	++wp->w_rs_updates;
+	if (type >= UPD_NOT_VALID)
+	{
+	    ++redrawstats.rs_win_full;
+	    ++wp->w_rs_full;
+	}
+	profile_start(&rs_tm);
+    }
+#endif
 
 #ifdef FEAT_TERMINAL
     // If this window contains a terminal, redraw works completely differently.
@@ -1594,6 +1658,10 @@ win_update(win_T *wp)
 	wp->w_redr_type = 0;
 	if (override_success)
 	    pop_highlight_overrides();
+# ifdef FEAT_PROFILE
+	if (rs_timing)
+	    redrawstats_win_time(wp, &rs_tm);
+# endif
 	return;
     }
 #endif
@@ -2545,6 +2613,13 @@ win_update(win_T *wp)
 
 		// Display one line.
 		row = win_line(wp, lnum, srow, wp->w_height, 0, &spv);
+#ifdef FEAT_PROFILE
+		if (rs_timing)
+		{
+		    ++redrawstats.rs_lines;
+		    ++wp->w_rs_lines;
+		}
+#endif
 
 #ifdef FEAT_FOLDING
 		wp->w_lines[idx].wl_folded = FALSE;
@@ -2862,6 +2937,10 @@ win_update(win_T *wp)
 
     if (override_success)
 	pop_highlight_overrides();
+#ifdef FEAT_PROFILE
+    if (rs_timing)
+	redrawstats_win_time(wp, &rs_tm);
+#endif
 }
 
 #if defined(FEAT_NETBEANS_INTG) || defined(FEAT_GUI)
@@ -3160,6 +3239,7 @@ redraw_after_callback(int call_update_screen, int do_message)
 {
     ++redrawing_for_callback;
 
+    out_frame_start();
     term_set_sync_output(TERM_SYNC_OUTPUT_ENABLE);
 
     if (State == MODE_HITRETURN || State == MODE_ASKMORE
@@ -3207,6 +3287,7 @@ redraw_after_callback(int call_update_screen, int do_message)
     }
     cursor_on();
     term_set_sync_output(TERM_SYNC_OUTPUT_DISABLE);
+    out_frame_end();
 #ifdef FEAT_GUI
     if (gui.in_use && !gui_mch_is_blink_off())
 	// Don't update the cursor when it is blinking and off to avoid
@@ -3481,6 +3562,97 @@ redraw_win_range_later(
     }
 }
 
+/*
+ * Redraw the buffer line of window "wp" that is displayed in screen row "row"
+ * of the window.  Uses what is currently displayed, the buffer is not
+ * accessed, thus a pointer obtained with ml_get() remains valid.
+ */
+    static void
+redraw_win_row_later(win_T *wp, int row)
+{
+    int	    i;
+    int	    r = 0;
+
+    for (i = 0; i < wp->w_lines_valid; ++i)
+    {
+	if (!wp->w_lines[i].wl_valid)
+	    break;
+	r += wp->w_lines[i].wl_size;
+	if (r > row)
+	{
+#ifdef FEAT_FOLDING
+	    redraw_win_range_later(wp, wp->w_lines[i].wl_lnum,
+					       wp->w_lines[i].wl_lastlnum);
+#else
+	    redrawWinline(wp, wp->w_lines[i].wl_lnum);
+#endif
+	    return;
+	}
+    }
+    // Filler lines after the last line are always redrawn, but when the
+    // displayed lines are unknown redraw the whole window.
+    if (i < wp->w_lines_valid || wp->w_lines_valid == 0)
+    {
+	wp->w_redr_type = UPD_NOT_VALID;
+	if (must_redraw < UPD_VALID)
+	    must_redraw = UPD_VALID;
+    }
+    else
+	redraw_win_later(wp, UPD_VALID);
+}
+
+/*
+ * Redraw the lines of the windows that are in the screen area with top-left
+ * "row" and "col" and size "height" by "width".  Used when something that was
+ * drawn on top of the windows, such as a popup, is removed or moved.  Only
+ * the affected lines are redrawn, not the whole windows.
+ */
+    void
+redraw_win_lines_in_area(int row, int col, int height, int width)
+{
+    int	    r;
+
+    for (r = row; r < row + height && r < screen_Rows; ++r)
+    {
+	int	    c;
+	win_T	    *prev_wp = NULL;
+
+	if (r >= cmdline_row)
+	{
+	    clear_cmdline = TRUE;
+	    continue;
+	}
+
+	for (c = col; c < col + width && c < screen_Columns; ++c)
+	{
+	    int	    line_cp = r;
+	    int	    col_cp = c;
+	    win_T   *wp;
+
+	    wp = mouse_find_win(&line_cp, &col_cp, IGNORE_POPUP);
+	    if (wp == NULL)
+	    {
+		// tabline or tabpanel
+		redraw_tabline = TRUE;
+#if defined(FEAT_TABPANEL)
+		redraw_tabpanel = TRUE;
+#endif
+	    }
+	    else if (wp != prev_wp)
+	    {
+		prev_wp = wp;
+		if (line_cp < 0)
+		    // window toolbar, drawn whenever the window is updated
+		    redraw_win_later(wp, UPD_VALID);
+		else if (line_cp < wp->w_height)
+		    redraw_win_row_later(wp, line_cp);
+		else if (line_cp == wp->w_height)
+		    wp->w_redr_status = TRUE;
+	    }
+	}
+    }
+}
+
 #ifdef FEAT_EVAL
 static bool redraw_cb_in_progress = false;
 
@@ -3664,3 +3836,240 @@ invoke_redraw_listener_start_or_end(bool start)
 	inside_redraw_on_start_cb = false;
 }
 #endif // FEAT_EVAL
+
+#if defined(FEAT_PROFILE) || defined(PROTO)
+/*
+ * Add the time since "tm" was started to "total".
+ */
+    void
+redrawstats_add_time(proftime_T *total, proftime_T *tm)
+{
+    profile_end(tm);
+    profile_add(total, tm);
+}
+
+/*
+ * Add the time since "tm" was started to the win_update() time of "wp".
+ */
+    static void
+redrawstats_win_time(win_T *wp, proftime_T *tm)
+{
+    profile_end(tm);
+    profile_add(&wp->w_rs_time, tm);
+}
+
+/*
+ * Get the windows in all tab pages, including popup windows, that were
+ * updated since the last ":redrawstats clear".  Sorted on the time spent,
+ * the slowest first.  Returns the number of windows, the array in "*wins"
+ * must be freed.
+ */
+    static int
+redrawstats_get_windows(win_T ***wins)
+{
+    garray_T	ga;
+    tabpage_T	*tp;
+    win_T	*wp;
+    int		i;
+    int		j;
+
+    ga_init2(&ga, sizeof(win_T *), 20);
+    FOR_ALL_TAB_WINDOWS(tp, wp)
+	if (wp->w_rs_updates > 0 && ga_grow(&ga, 1) == OK)
+	    ((win_T **)ga.ga_data)[ga.ga_len++] = wp;
+# ifdef FEAT_PROP_POPUP
+    FOR_ALL_POPUPWINS(wp)
+	if (wp->w_rs_updates > 0 && ga_grow(&ga, 1) == OK)
+	    ((win_T **)ga.ga_data)[ga.ga_len++] = wp;
+    FOR_ALL_TABPAGES(tp)
+	FOR_ALL_POPUPWINS_IN_TAB(tp, wp)
+	    if (wp->w_rs_updates > 0 && ga_grow(&ga, 1) == OK)
+		((win_T **)ga.ga_data)[ga.ga_len++] = wp;
+# endif
+
+    // There are only a few windows, a simple insertion sort will do.
+    for (i = 1; i < ga.ga_len; ++i)
+    {
+	wp = ((win_T **)ga.ga_data)[i];
+	for (j = i; j > 0 && profile_cmp(
+		       &((win_T **)ga.ga_data)[j - 1]->w_rs_time,
+						       &wp->w_rs_time) > 0; --j)
+	    ((win_T **)ga.ga_data)[j] = ((win_T **)ga.ga_data)[j - 1];
+	((win_T **)ga.ga_data)[j] = wp;
+    }
+
+    *wins = (win_T **)ga.ga_data;
+    return ga.ga_len;
+}
+
+    static void
+redrawstats_clear_win(win_T *wp)
+{
+    wp->w_rs_updates = 0;
+    wp->w_rs_full = 0;
+    wp->w_rs_lines = 0;
+    profile_zero(&wp->w_rs_time);
+}
+
+/*
+ * Set all the counters to zero.
+ */
+    static void
+redrawstats_clear(void)
+{
+    tabpage_T	*tp;
+    win_T	*wp;
+
+    CLEAR_FIELD(redrawstats);
+    profile_zero(&redrawstats.rs_time);
+    profile_zero(&redrawstats.rs_syn_time);
+    profile_zero(&redrawstats.rs_popup_time);
+    FOR_ALL_TAB_WINDOWS(tp, wp)
+	redrawstats_clear_win(wp);
+# ifdef FEAT_PROP_POPUP
+    FOR_ALL_POPUPWINS(wp)
+	redrawstats_clear_win(wp);
+    FOR_ALL_TABPAGES(tp)
+	FOR_ALL_POPUPWINS_IN_TAB(tp, wp)
+	    redrawstats_clear_win(wp);
+# endif
+}
+
+/*
+ * ":redrawstats report".
+ */
+    static void
+redrawstats_report(void)
+{
+    win_T	**wins;
+    win_T	*wp;
+    char_u	*p;
+    int		count;
+    int		idx;
+
+    smsg(_("Screen updates: %ld, cleared: %ld"),
+				 redrawstats.rs_updates, redrawstats.rs_clear);
+    smsg(_("Window updates: %ld, whole window: %ld, lines drawn: %ld"),
+			 redrawstats.rs_win_updates, redrawstats.rs_win_full,
+							  redrawstats.rs_lines);
+    smsg(_("Screen cells compared: %ld, changed: %ld"),
+				redrawstats.rs_cells, redrawstats.rs_changed);
+    smsg(_("Terminal output: %ld bytes in %ld writes"),
+			       redrawstats.rs_bytes, redrawstats.rs_flushes);
+    msg_putchar('\n');
+    msg_puts(_("Time: "));
+    msg_puts(profile_msg(&redrawstats.rs_time));
+    msg_puts(_(", syntax: "));
+    msg_puts(profile_msg(&redrawstats.rs_syn_time));
+    msg_puts(_(", popups: "));
+    msg_puts(profile_msg(&redrawstats.rs_popup_time));
+    msg_putchar('\n');
+
+    count = redrawstats_get_windows(&wins);
+    if (count == 0)
+	return;
+    msg_putchar('\n');
+    msg_puts_title(_("  TIME         UPDATES  WHOLE    LINES    WINID  BUFFER"));
+    for (idx = 0; idx < count && !got_int; ++idx)
+    {
+	wp = wins[idx];
+	msg_putchar('\n');
+	msg_puts(profile_msg(&wp->w_rs_time));
+	msg_puts(" ");
+	msg_advance(15);
+	msg_outnum(wp->w_rs_updates);
+	msg_puts(" ");
+	msg_advance(24);
+	msg_outnum(wp->w_rs_full);
+	msg_puts(" ");
+	msg_advance(33);
+	msg_outnum(wp->w_rs_lines);
+	msg_puts(" ");
+	msg_advance(42);
+	msg_outnum(wp->w_id);
+	msg_puts(" ");
+	msg_advance(49);
+	p = buf_spname(wp->w_buffer);
+	msg_outtrans(p != NULL ? p : wp->w_buffer->b_fname);
+    }
+    msg_putchar('\n');
+    vim_free(wins);
+}
+
+/*
+ * ":redrawstats {on,off,clear,report}".
+ */
+    void
+ex_redrawstats(exarg_T *eap)
+{
+    if (STRCMP(eap->arg, "on") == 0)
+	redrawstats_on = TRUE;
+    else if (STRCMP(eap->arg, "off") == 0)
+	redrawstats_on = FALSE;
+    else if (STRCMP(eap->arg, "clear") == 0)
+	redrawstats_clear();
+    else if (STRCMP(eap->arg, "report") == 0)
+	redrawstats_report();
+    else
+	semsg(_(e_invalid_argument_str), eap->arg);
+}
+#endif
+
+#if defined(FEAT_EVAL) || defined(PROTO)
+/*
+ * "redrawstats()" function
+ */
+    void
+f_redrawstats(typval_T *argvars UNUSED, typval_T *rettv)
+{
+# ifdef FEAT_PROFILE
+    dict_T	*d;
+    list_T	*l;
+    dict_T	*wd;
+    win_T	**wins;
+    int		count;
+    int		idx;
+# endif
+
+    if (rettv_dict_alloc(rettv) == FAIL)
+	return;
+# ifdef FEAT_PROFILE
+    d = rettv->vval.v_dict;
+    dict_add_number(d, "updates", redrawstats.rs_updates);
+    dict_add_number(d, "clear", redrawstats.rs_clear);
+    dict_add_number(d, "winupdates", redrawstats.rs_win_updates);
+    dict_add_number(d, "winwhole", redrawstats.rs_win_full);
+    dict_add_number(d, "lines", redrawstats.rs_lines);
+    dict_add_number(d, "cells", redrawstats.rs_cells);
+    dict_add_number(d, "changed", redrawstats.rs_changed);
+    dict_add_number(d, "bytes", redrawstats.rs_bytes);
+    dict_add_number(d, "writes", redrawstats.rs_flushes);
+    dict_add_float(d, "time", profile_float(&redrawstats.rs_time));
+    dict_add_float(d, "syntime", profile_float(&redrawstats.rs_syn_time));
+    dict_add_float(d, "popuptime", profile_float(&redrawstats.rs_popup_time));
+
+    l = list_alloc();
+    if (l == NULL)
+	return;
+    if (dict_add_list(d, "windows", l) == FAIL)
+    {
+	list_free(l);
+	return;
+    }
+    count = redrawstats_get_windows(&wins);
+    for (idx = 0; idx < count; ++idx)
+    {
+	wd = dict_alloc();
+	if (wd == NULL || list_append_dict(l, wd) == FAIL)
+	    break;
+	dict_add_number(wd, "winid", wins[idx]->w_id);
+	dict_add_number(wd, "bufnr", wins[idx]->w_buffer->b_fnum);
+	dict_add_number(wd, "updates", wins[idx]->w_rs_updates);
+	dict_add_number(wd, "whole", wins[idx]->w_rs_full);
+	dict_add_number(wd, "lines", wins[idx]->w_rs_lines);
+	dict_add_float(wd, "time", profile_float(&wins[idx]->w_rs_time));
+    }
+    vim_free(wins);
+# endif
+}
+#endif
@@ -3199,12 +3199,12 @@ pattern_match(char_u *pat, char_u *text, int ic)
     // avoid 'l' flag in 'cpoptions'
     save_cpo = p_cpo;
     p_cpo = empty_option;
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog != NULL)
     {
 	regmatch.rm_ic = ic;
 	matches = vim_regexec_nl(&regmatch, text, (colnr_T)0);
-	vim_regfree(regmatch.regprog);
+	vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
     }
     p_cpo = save_cpo;
     return matches;
@@ -8117,7 +8117,7 @@ do_string_sub(
     ga_init2(&ga, 1, 200);
 
     regmatch.rm_ic = p_ic;
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog != NULL)
     {
 	char_u	*tail = str;
@@ -8186,7 +8186,7 @@ do_string_sub(
 	    ga.ga_len += (int)(end - tail);
 	}
 
-	vim_regfree(regmatch.regprog);
+	vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
     }
 
     if (ga.ga_data != NULL)
@@ -2732,12 +2732,16 @@ static const funcentry_T global_functions[] =
 			ret_number,	    f_redraw_listener_add},
     {"redraw_listener_remove", 1, 1, FEARG_1, arg1_number,
 			ret_void,	    f_redraw_listener_remove},
+    {"redrawstats",	0, 0, 0,	    NULL,
+			ret_dict_any,	    f_redrawstats},
     {"reduce",		2, 3, FEARG_1,	    arg23_reduce,
 			ret_any,	    f_reduce},
     {"reg_executing",	0, 0, 0,	    NULL,
 			ret_string,	    f_reg_executing},
     {"reg_recording",	0, 0, 0,	    NULL,
 			ret_string,	    f_reg_recording},
+    {"regexpstats",	0, 0, 0,	    NULL,
+			ret_list_dict_any,  f_regexpstats},
     {"reltime",		0, 2, FEARG_1,	    arg2_list_number,
 			ret_list_any,	    f_reltime},
     {"reltimefloat",	1, 1, FEARG_1,	    arg1_list_number,
@@ -9264,7 +9268,7 @@ find_some_match(typval_T *argvars, typval_T *rettv, matchtype_T type)
 	    goto theend;
     }
 
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog != NULL)
     {
 	regmatch.rm_ic = p_ic;
@@ -9371,7 +9375,7 @@ find_some_match(typval_T *argvars, typval_T *rettv, matchtype_T type)
 		rettv->vval.v_number += (varnumber_T)(str - expr);
 	    }
 	}
-	vim_regfree(regmatch.regprog);
+	vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
     }
 
 theend:
@@ -9539,7 +9543,7 @@ f_matchbufline(typval_T *argvars, typval_T *rettv)
     save_cpo = p_cpo;
     p_cpo = empty_option;
 
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog == NULL)
 	goto theend;
     regmatch.rm_ic = p_ic;
@@ -9554,7 +9558,7 @@ f_matchbufline(typval_T *argvars, typval_T *rettv)
     }
 
 cleanup:
-    vim_regfree(regmatch.regprog);
+    vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
 
 theend:
     p_cpo = save_cpo;
@@ -9630,7 +9634,7 @@ f_matchstrlist(typval_T *argvars, typval_T *rettv)
     save_cpo = p_cpo;
     p_cpo = empty_option;
 
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog == NULL)
 	goto theend;
     regmatch.rm_ic = p_ic;
@@ -9669,7 +9673,7 @@ f_matchstrlist(typval_T *argvars, typval_T *rettv)
     }
 
 cleanup:
-    vim_regfree(regmatch.regprog);
+    vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
 
 theend:
     p_cpo = save_cpo;
@@ -12197,7 +12201,7 @@ f_split(typval_T *argvars, typval_T *rettv)
     if (typeerr)
 	goto theend;
 
-    regmatch.regprog = vim_regcomp(pat, RE_MAGIC + RE_STRING);
+    regmatch.regprog = vim_regcomp_cached(pat, RE_MAGIC + RE_STRING);
     if (regmatch.regprog != NULL)
     {
 	regmatch.rm_ic = FALSE;
@@ -12229,7 +12233,7 @@ f_split(typval_T *argvars, typval_T *rettv)
 	    str = regmatch.endp[0];
 	}
 
-	vim_regfree(regmatch.regprog);
+	vim_regfree_cached(regmatch.regprog, pat, RE_MAGIC + RE_STRING);
     }
 
 theend:
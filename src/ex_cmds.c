@@ -4022,6 +4022,8 @@ ex_substitute(exarg_T *eap)
     pos_T	old_cursor = curwin->w_cursor;
     int		start_nsubs;
     int		keeppatterns = cmdmod.cmod_flags & CMOD_KEEPPATTERNS;
+    int		sub_is_expr;		// substitute with "\=expr"
+    u_batch_T	undo_batch;		// for saving lines in one entry
 #ifdef FEAT_EVAL
     int		save_ma = 0;
     int		save_sandbox = 0;
@@ -4341,6 +4343,7 @@ ex_substitute(exarg_T *eap)
 	regmatch.rmm_ic = FALSE;
 
     sub_firstline = NULL;
+    CLEAR_FIELD(undo_batch);
 
     /*
      * If the substitute pattern starts with "\=" then it's an expression.
@@ -4349,7 +4352,8 @@ ex_substitute(exarg_T *eap)
      * pattern.  We do it here once to avoid it to be replaced over and over
      * again.
      */
-    if (sub[0] == '\\' && sub[1] == '=')
+    sub_is_expr = sub[0] == '\\' && sub[1] == '=';
+    if (sub_is_expr)
     {
 	p = vim_strsave(sub);
 	vim_free(sub);
@@ -5134,7 +5138,12 @@ skip:
 			prev_matchcol = (colnr_T)STRLEN(sub_firstline)
 							      - prev_matchcol;
 
-			if (u_savesub(lnum) != OK)
+			// Without asking and without an expression, which
+			// might change the buffer, lines are saved for undo
+			// in one entry, that is much faster for many lines.
+			if ((subflags.do_ask || sub_is_expr
+				    ? u_savesub(lnum)
+				    : u_savesub_batch(lnum, &undo_batch)) != OK)
 			    break;
 			ml_replace(lnum, new_start, TRUE);
 #ifdef FEAT_PROP_POPUP
@@ -5231,6 +5240,7 @@ skip:
 
 outofmem:
     vim_free(sub_firstline); // may have to free allocated copy of the line
+    u_savesub_batch_end(&undo_batch);
 
 #ifdef FEAT_PROP_POPUP
     vim_free(text_props);
@@ -1298,6 +1298,9 @@ EXCMD(CMD_redraw,	"redraw",	ex_redraw,
 EXCMD(CMD_redrawstatus,	"redrawstatus",	ex_redrawstatus,
 	EX_BANG|EX_TRLBAR|EX_CMDWIN|EX_LOCK_OK,
 	ADDR_NONE),
+EXCMD(CMD_redrawstats,	"redrawstats",	ex_redrawstats,
+	EX_NEEDARG|EX_WORD1|EX_TRLBAR|EX_CMDWIN|EX_LOCK_OK,
+	ADDR_NONE),
 EXCMD(CMD_redrawtabline, "redrawtabline", ex_redrawtabline,
 	EX_TRLBAR|EX_CMDWIN|EX_LOCK_OK,
 	ADDR_NONE),
@@ -1307,6 +1310,9 @@ EXCMD(CMD_redrawtabpanel, "redrawtabpanel", ex_redrawtabpanel,
 EXCMD(CMD_registers,	"registers",	ex_display,
 	EX_EXTRA|EX_NOTRLCOM|EX_TRLBAR|EX_SBOXOK|EX_CMDWIN|EX_LOCK_OK,
 	ADDR_NONE),
+EXCMD(CMD_regprofile,	"regprofile",	ex_regprofile,
+	EX_NEEDARG|EX_WORD1|EX_TRLBAR|EX_CMDWIN|EX_LOCK_OK,
+	ADDR_NONE),
 EXCMD(CMD_resize,	"resize",	ex_resize,
 	EX_RANGE|EX_TRLBAR|EX_WORD1|EX_CMDWIN|EX_LOCK_OK,
 	ADDR_OTHER),
@@ -366,6 +366,8 @@ static void	ex_folddo(exarg_T *eap);
 
 #ifndef FEAT_PROFILE
 # define ex_profile		ex_ni
+# define ex_redrawstats		ex_ni
+# define ex_regprofile		ex_ni
 #endif
 #ifndef FEAT_TERMINAL
 # define ex_terminal		ex_ni
@@ -27,10 +27,6 @@
 // Is there any system that doesn't have access()?
 #define USE_MCH_ACCESS
 
-// Bitmask with 0x80 set in each byte of a long_u word, used to detect
-// non-ASCII bytes (high bit set) in multiple bytes at once.
-#define NONASCII_MASK (((long_u)-1 / 0xFF) * 0x80)
-
 #if defined(__hpux) && !defined(HAVE_DIRFD)
 # define dirfd(x) ((x)->__dd_fd)
 # define HAVE_DIRFD
@@ -151,6 +147,7 @@ readfile(
     linenr_T	lnum = from;
     char_u	*ptr = NULL;		// pointer into read buffer
     char_u	*buffer = NULL;		// read buffer
+    long	buffer_size = 0;	// allocated size of "buffer" or zero
     char_u	*new_buffer = NULL;	// init to shut up gcc
     char_u	*line_start = NULL;	// init to shut up gcc
     int		wasempty;		// buffer was empty before reading
@@ -159,6 +156,7 @@ readfile(
     char_u	*p;
     off_T	filesize = 0;
     int		skip_read = FALSE;
+    int		read_large = FALSE;	// reading a big regular file
 #ifdef FEAT_CRYPT
     off_T       filesize_disk = 0;      // file size read from disk
     off_T       filesize_count = 0;     // counter
@@ -442,6 +440,7 @@ readfile(
 #ifdef FEAT_CRYPT
 	    filesize_disk = st.st_size;
 #endif
+	    read_large = S_ISREG(st.st_mode) && st.st_size > 0x100000L;
 #ifdef UNIX
 	    /*
 	     * Use the protection bits of the original file for the swap file.
@@ -1167,7 +1166,9 @@ retry:
 		// Use buffer >= 64K.  Add linerest to double the size if the
 		// line gets very long, to avoid a lot of copying. But don't
 		// read more than 1 Mbyte at a time, so we can be interrupted.
-		size = 0x10000L + linerest;
+		// For a big file start with 1 Mbyte, that avoids many read()
+		// calls and passes through the loop below.
+		size = (read_large ? 0x100000L : 0x10000L) + linerest;
 		if (size > 0x100000L)
 		    size = 0x100000L;
 #endif
@@ -1189,22 +1190,35 @@ retry:
 	{
 	    if (!skip_read)
 	    {
-		for ( ; size >= 10; size = (long)((long_u)size >> 1))
+		if (buffer != NULL && linerest < buffer_size / 4)
 		{
-		    if ((new_buffer = lalloc(size + linerest + 1,
-							      FALSE)) != NULL)
-			break;
+		    // Most of the previous buffer is free, move the characters
+		    // of the unfinished line to the start and reuse it.
+		    if (linerest)
+			mch_memmove(buffer, ptr - linerest, (size_t)linerest);
+		    size = buffer_size - linerest - 1;
 		}
-		if (new_buffer == NULL)
+		else
 		{
-		    do_outofmem_msg((long_u)(size * 2 + linerest + 1));
-		    error = TRUE;
-		    break;
+		    for ( ; size >= 10; size = (long)((long_u)size >> 1))
+		    {
+			if ((new_buffer = lalloc(size + linerest + 1,
+							      FALSE)) != NULL)
+			    break;
+		    }
+		    if (new_buffer == NULL)
+		    {
+			do_outofmem_msg((long_u)(size * 2 + linerest + 1));
+			error = TRUE;
+			break;
+		    }
+		    if (linerest)   // copy characters from the previous buffer
+			mch_memmove(new_buffer, ptr - linerest,
+							     (size_t)linerest);
+		    vim_free(buffer);
+		    buffer = new_buffer;
+		    buffer_size = size + linerest + 1;
 		}
-		if (linerest)	// copy characters from the previous buffer
-		    mch_memmove(new_buffer, ptr - linerest, (size_t)linerest);
-		vim_free(buffer);
-		buffer = new_buffer;
 		ptr = buffer + linerest;
 		line_start = buffer;
 
@@ -1447,6 +1461,7 @@ retry:
 			{
 			    vim_free(buffer);
 			    buffer = new_buffer;
+			    buffer_size = 0;	// size not known, don't reuse
 			    new_buffer = NULL;
 			    line_start = buffer;
 			    ptr = buffer + linerest + conv_restlen;
@@ -2065,20 +2080,9 @@ retry:
 		    int	 todo;
 		    int	 l;
 
-		    // Skip ASCII bytes quickly using word-at-a-time check.
-		    {
-			char_u *ascii_end = ptr + size;
-			while (ascii_end - p >= (long)sizeof(long_u))
-			{
-			    long_u word;
-			    memcpy(&word, p, sizeof(long_u));
-			    if (word & NONASCII_MASK)
-				break;
-			    p += sizeof(long_u);
-			}
-			while (p < ascii_end && *p < 0x80)
-			    ++p;
-		    }
+		    // Skip over valid text quickly, only illegal bytes and an
+		    // incomplete sequence at the end need to be looked at.
+		    p += utf_valid_len(p, (int)((ptr + size) - p));
 
 		    todo = (int)((ptr + size) - p);
 		    if (todo <= 0)
@@ -4244,6 +4248,30 @@ move_lines(buf_T *frombuf, buf_T *tobuf)
     return retval;
 }
 
+#ifdef FEAT_SYN_HL
+/*
+ * Return the number of the first line that differs between "oldbuf" and
+ * "newbuf".
+ */
+    static linenr_T
+first_changed_line(buf_T *oldbuf, buf_T *newbuf)
+{
+    linenr_T	lnum;
+    colnr_T	len;
+
+    for (lnum = 1; lnum <= oldbuf->b_ml.ml_line_count
+				   && lnum <= newbuf->b_ml.ml_line_count; ++lnum)
+    {
+	len = ml_get_buf_len(oldbuf, lnum);
+	if (len != ml_get_buf_len(newbuf, lnum)
+		|| memcmp(ml_get_buf(oldbuf, lnum, FALSE),
+				  ml_get_buf(newbuf, lnum, FALSE), len) != 0)
+	    break;
+    }
+    return lnum;
+}
+#endif
+
 /*
  * Check if buffer "buf" has been changed.
  * Also check if the file for a new buffer unexpectedly appeared.
@@ -4637,6 +4665,9 @@ buf_reload(buf_T *buf, int orig_mode, int reload_options)
     aco_save_T	aco;
     int		flags = READ_NEW;
     int		prepped = OK;
+#ifdef FEAT_SYN_HL
+    linenr_T	first_changed = 1;
+#endif
 
     // Set curwin/curbuf for "buf" and save some things.
     aucmd_prepbuf(&aco, buf);
@@ -4700,6 +4731,11 @@ buf_reload(buf_T *buf, int orig_mode, int reload_options)
 	    }
 	}
 
+#ifdef FEAT_SYN_HL
+	if (saved == OK)
+	    syn_stack_reload_save(curbuf);
+#endif
+
 	if (saved == OK)
 	{
 	    int old_msg_silent = msg_silent;
@@ -4745,6 +4781,11 @@ buf_reload(buf_T *buf, int orig_mode, int reload_options)
 	}
 	vim_free(ea.cmd);
 
+#ifdef FEAT_SYN_HL
+	if (savebuf != NULL && bufref_valid(&bufref))
+	    first_changed = first_changed_line(savebuf, curbuf);
+#endif
+
 	if (savebuf != NULL && bufref_valid(&bufref))
 	    wipe_buffer(savebuf, FALSE);
 
@@ -4783,6 +4824,13 @@ buf_reload(buf_T *buf, int orig_mode, int reload_options)
 
 	// Modelines must override settings done by autocommands.
 	do_modelines(0);
+
+#ifdef FEAT_SYN_HL
+	// Syntax states before the first changed line can be used again.
+	// Done after the modelines, they may change 'iskeyword'.
+	if (saved == OK)
+	    syn_stack_reload_restore(curbuf, first_changed);
+#endif
     }
 
     // restore curwin/curbuf and a few other things
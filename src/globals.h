@@ -919,6 +919,12 @@ EXTERN int	updating_screen INIT(= FALSE);
 // must_redraw to be set.
 EXTERN int	redraw_not_allowed INIT(= FALSE);
 
+#ifdef FEAT_PROFILE
+// Counters for ":redrawstats", only updated when "redrawstats_on" is set.
+EXTERN int		redrawstats_on INIT(= FALSE);
+EXTERN redrawstats_T	redrawstats;
+#endif
+
 #ifdef MESSAGE_QUEUE
 // While closing windows or buffers messages should not be handled to avoid
 // using invalid windows or buffers.
@@ -1325,6 +1325,12 @@ ins_compl_del_pum(void)
 	return;
 
     pum_undisplay();
+    // pum_undisplay() only redraws the lines below the menu, the inserted
+    // text may have the ComplMatchIns highlighting.
+    if (compl_lnum > curwin->w_cursor.lnum)
+	redraw_win_range_later(curwin, curwin->w_cursor.lnum, compl_lnum);
+    else
+	redraw_win_range_later(curwin, compl_lnum, curwin->w_cursor.lnum);
     VIM_CLEAR(compl_match_array);
 }
 
@@ -120,6 +120,10 @@
 # include <wchar.h>
 #endif
 
+// Bitmask with 0x80 set in each byte of a long_u word, used to detect
+// non-ASCII bytes (high bit set) in multiple bytes at once.
+#define NONASCII_MASK (((long_u)-1 / 0xFF) * 0x80)
+
 static int dbcs_char2len(int c);
 static int dbcs_char2bytes(int c, char_u *buf);
 static int dbcs_ptr2len(char_u *p);
@@ -2280,6 +2284,52 @@ utf_ptr2len_len(char_u *p, int size)
     return len;
 }
 
+/*
+ * Return the number of bytes at the start of "p[size]" that are ASCII or
+ * complete, valid UTF-8 byte sequences.  Stops at the first illegal byte or
+ * incomplete sequence at the end, the caller has to deal with that.
+ * Used to check a big block of text at once, e.g. when reading a file.
+ */
+    int
+utf_valid_len(char_u *p, int size)
+{
+    char_u	*s = p;
+    char_u	*end = p + size;
+    int		len;
+    int		i;
+
+    while (s < end)
+    {
+	if (*s < 0x80)
+	{
+	    // Skip ASCII bytes quickly, checking a whole word at a time.
+	    while (end - s >= (long)sizeof(long_u))
+	    {
+		long_u	word;
+
+		memcpy(&word, s, sizeof(long_u));
+		if (word & NONASCII_MASK)
+		    break;
+		s += sizeof(long_u);
+	    }
+	    while (s < end && *s < 0x80)
+		++s;
+	    continue;
+	}
+
+	len = utf8len_tab_zero[*s];
+	if (len <= 1 || len > end - s)
+	    break;
+	for (i = 1; i < len; ++i)
+	    if ((s[i] & 0xc0) != 0x80)
+		break;
+	if (i < len)
+	    break;
+	s += len;
+    }
+    return (int)(s - p);
+}
+
 /*
  * Return the number of bytes the UTF-8 encoding of the character at "p" takes.
  * This includes following composing characters.
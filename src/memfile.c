@@ -65,7 +65,7 @@ extern int dos2;			// this is in os_amiga.c
 
 static long_u	total_mem_used = 0;	// total memory used for memfiles
 
-static void mf_ins_hash(memfile_T *, bhdr_T *);
+static int mf_ins_hash(memfile_T *, bhdr_T *);
 static void mf_rem_hash(memfile_T *, bhdr_T *);
 static bhdr_T *mf_find_hash(memfile_T *, blocknr_T);
 static void mf_ins_used(memfile_T *, bhdr_T *);
@@ -84,7 +84,7 @@ static void mf_hash_init(mf_hashtab_T *);
 static void mf_hash_free(mf_hashtab_T *);
 static void mf_hash_free_all(mf_hashtab_T *);
 static mf_hashitem_T *mf_hash_find(mf_hashtab_T *, blocknr_T);
-static void mf_hash_add_item(mf_hashtab_T *, mf_hashitem_T *);
+static int mf_hash_add_item(mf_hashtab_T *, mf_hashitem_T *);
 static void mf_hash_rem_item(mf_hashtab_T *, mf_hashitem_T *);
 static int mf_hash_grow(mf_hashtab_T *);
 
@@ -386,10 +386,31 @@ mf_new(memfile_T *mfp, int negative, int page_count)
 	}
     }
     hp->bh_flags = BH_LOCKED | BH_DIRTY;	// new block is always dirty
-    mfp->mf_dirty = MF_DIRTY_YES;
     hp->bh_page_count = page_count;
+    if (mf_ins_hash(mfp, hp) == FAIL)
+    {
+	// out of memory, give back the block number
+	if (hp->bh_bnum < 0)
+	{
+	    mfp->mf_blocknr_min++;
+	    mfp->mf_neg_count--;
+	    mf_free_bhdr(hp);
+	}
+	else if (hp->bh_bnum + page_count == mfp->mf_blocknr_max)
+	{
+	    mfp->mf_blocknr_max -= page_count;
+	    mf_free_bhdr(hp);
+	}
+	else
+	{
+	    // the number came from the free list, put it back there
+	    vim_free(hp->bh_data);
+	    mf_ins_free(mfp, hp);
+	}
+	return NULL;
+    }
+    mfp->mf_dirty = MF_DIRTY_YES;
     mf_ins_used(mfp, hp);
-    mf_ins_hash(mfp, hp);
 
     /*
      * Init the data to all zero, to avoid reading uninitialized data.
@@ -439,21 +460,18 @@ mf_get(memfile_T *mfp, blocknr_T nr, int page_count)
 	hp->bh_bnum = nr;
 	hp->bh_flags = 0;
 	hp->bh_page_count = page_count;
-	if (mf_read(mfp, hp) == FAIL)	    // cannot read the block!
+	if (mf_read(mfp, hp) == FAIL	    // cannot read the block!
+		|| mf_ins_hash(mfp, hp) == FAIL)
 	{
 	    mf_free_bhdr(hp);
 	    return NULL;
 	}
     }
     else
-    {
 	mf_rem_used(mfp, hp);	// remove from list, insert in front below
-	mf_rem_hash(mfp, hp);
-    }
 
     hp->bh_flags |= BH_LOCKED;
     mf_ins_used(mfp, hp);	// put in front of used list
-    mf_ins_hash(mfp, hp);	// put in front of hash list
 
     return hp;
 }
@@ -515,7 +533,8 @@ mf_free(memfile_T *mfp, bhdr_T *hp)
  *  MFS_ALL	If not given, blocks with negative numbers are not synced,
  *		even when they are dirty!
  *  MFS_STOP	Stop syncing when a character becomes available, but sync at
- *		least one block.
+ *		least one block.  Also skip flushing then, the memfile stays
+ *		dirty to do that the next time.
  *  MFS_FLUSH	Make sure buffers are flushed to disk, so they will survive a
  *		system crash.
  *  MFS_ZERO	Only write block 0.
@@ -580,6 +599,16 @@ mf_sync(memfile_T *mfp, int flags)
     if (hp == NULL || status == FAIL)
 	mfp->mf_dirty = MF_DIRTY_NO;
 
+    // Flushing may block for a long time, e.g. when the swap file is on a
+    // network file system.  Don't do that while the user is typing, keep
+    // the memfile dirty so that it is done when syncing the next time.
+    if ((flags & (MFS_FLUSH | MFS_STOP)) == (MFS_FLUSH | MFS_STOP)
+						&& status == OK && ui_char_avail())
+    {
+	mfp->mf_dirty = MF_DIRTY_YES;
+	flags &= ~MFS_FLUSH;
+    }
+
     if ((flags & MFS_FLUSH) && *p_sws != NUL)
     {
 #if defined(UNIX)
@@ -678,16 +707,17 @@ mf_set_dirty(memfile_T *mfp)
 }
 
 /*
- * insert block *hp in front of hashlist of memfile *mfp
+ * insert block *hp in the hashtable of memfile *mfp
+ * Returns FAIL when out of memory.
  */
-    static void
+    static int
 mf_ins_hash(memfile_T *mfp, bhdr_T *hp)
 {
-    mf_hash_add_item(&mfp->mf_hash, (mf_hashitem_T *)hp);
+    return mf_hash_add_item(&mfp->mf_hash, (mf_hashitem_T *)hp);
 }
 
 /*
- * remove block *hp from hashlist of memfile list *mfp
+ * remove block *hp from the hashtable of memfile *mfp
  */
     static void
 mf_rem_hash(memfile_T *mfp, bhdr_T *hp)
@@ -696,7 +726,7 @@ mf_rem_hash(memfile_T *mfp, bhdr_T *hp)
 }
 
 /*
- * look in hash lists of memfile *mfp for block header with number 'nr'
+ * look in the hashtable of memfile *mfp for block header with number 'nr'
  */
     static bhdr_T *
 mf_find_hash(memfile_T *mfp, blocknr_T nr)
@@ -792,7 +822,7 @@ mf_release(memfile_T *mfp, int page_count)
 	return NULL;
 
     for (hp = mfp->mf_used_last; hp != NULL; hp = hp->bh_prev)
-	if (!(hp->bh_flags & BH_LOCKED))
+	if (!(hp->bh_flags & BH_LOCKED) && hp->bh_pinned == 0)
 	    break;
     if (hp == NULL)	// not a single one that can be released
 	return NULL;
@@ -852,20 +882,22 @@ mf_release_all(void)
 	    // only if there is a swapfile
 	    if (mfp->mf_fd >= 0)
 	    {
-		for (hp = mfp->mf_used_last; hp != NULL; )
+		bhdr_T	*prev;
+
+		for (hp = mfp->mf_used_last; hp != NULL; hp = prev)
 		{
-		    if (!(hp->bh_flags & BH_LOCKED)
+		    // writing doesn't change the used list, only "hp" is
+		    // removed from it
+		    prev = hp->bh_prev;
+		    if (!(hp->bh_flags & BH_LOCKED) && hp->bh_pinned == 0
 			    && (!(hp->bh_flags & BH_DIRTY)
 				|| mf_write(mfp, hp) != FAIL))
 		    {
 			mf_rem_used(mfp, hp);
 			mf_rem_hash(mfp, hp);
 			mf_free_bhdr(hp);
-			hp = mfp->mf_used_last;	// re-start, list was changed
 			retval = TRUE;
 		    }
-		    else
-			hp = hp->bh_prev;
 		}
 	    }
 	}
@@ -890,6 +922,7 @@ mf_alloc_bhdr(memfile_T *mfp, int page_count)
 	return NULL;
     }
     hp->bh_page_count = page_count;
+    hp->bh_pinned = 0;
     return hp;
 }
 
@@ -1121,6 +1154,14 @@ mf_trans_add(memfile_T *mfp, bhdr_T *hp)
     if ((np = ALLOC_ONE(NR_TRANS)) == NULL)
 	return FAIL;
 
+    // Insert "np" into "mf_trans" hashtable with key "np->nt_old_bnum"
+    np->nt_old_bnum = hp->bh_bnum;
+    if (mf_hash_add_item(&mfp->mf_trans, (mf_hashitem_T *)np) == FAIL)
+    {
+	vim_free(np);
+	return FAIL;
+    }
+
 /*
  * Get a new number for the block.
  * If the first item in the free list has sufficient pages, use its number
@@ -1152,15 +1193,13 @@ mf_trans_add(memfile_T *mfp, bhdr_T *hp)
 	mfp->mf_blocknr_max += page_count;
     }
 
-    np->nt_old_bnum = hp->bh_bnum;	    // adjust number
     np->nt_new_bnum = new_bnum;
 
-    mf_rem_hash(mfp, hp);		    // remove from old hash list
+    // Adjust the number.  Removing it from the hashtable leaves room, thus
+    // inserting it again can't fail.
+    mf_rem_hash(mfp, hp);
     hp->bh_bnum = new_bnum;
-    mf_ins_hash(mfp, hp);		    // insert in new hash list
-
-    // Insert "np" into "mf_trans" hashtable with key "np->nt_old_bnum"
-    mf_hash_add_item(&mfp->mf_trans, (mf_hashitem_T *)np);
+    (void)mf_ins_hash(mfp, hp);
 
     return OK;
 }
@@ -1184,7 +1223,7 @@ mf_trans_del(memfile_T *mfp, blocknr_T old_nr)
     mfp->mf_neg_count--;
     new_bnum = np->nt_new_bnum;
 
-    // remove entry from the trans list
+    // remove entry from the trans hashtable
     mf_hash_rem_item(&mfp->mf_trans, (mf_hashitem_T *)np);
 
     vim_free(np);
@@ -1312,13 +1351,18 @@ mf_do_open(
  */
 
 /*
- * The number of buckets in the hashtable is increased by a factor of
- * MHT_GROWTH_FACTOR when the average number of items per bucket
- * exceeds 2 ^ MHT_LOG_LOAD_FACTOR.
+ * The number of slots in the hashtable is increased by a factor of
+ * MHT_GROWTH_FACTOR when more than half of them are in use.
  */
-#define MHT_LOG_LOAD_FACTOR 6
 #define MHT_GROWTH_FACTOR   2   // must be a power of two
 
+/*
+ * Get the slot to start looking for "key".  Block numbers are mostly
+ * consecutive, multiplying by an odd number spreads them over the table so
+ * that they don't form long runs of used slots.
+ */
+#define MHT_HASH(mht, key) (((long_u)(key) * 0x9e3779b1UL) & (mht)->mht_mask)
+
 /*
  * Initialize an empty hash table.
  */
@@ -1348,15 +1392,9 @@ mf_hash_free(mf_hashtab_T *mht)
 mf_hash_free_all(mf_hashtab_T *mht)
 {
     long_u	    idx;
-    mf_hashitem_T   *mhi;
-    mf_hashitem_T   *next;
 
     for (idx = 0; idx <= mht->mht_mask; idx++)
-	for (mhi = mht->mht_buckets[idx]; mhi != NULL; mhi = next)
-	{
-	    next = mhi->mhi_next;
-	    vim_free(mhi);
-	}
+	vim_free(mht->mht_buckets[idx]);
 
     mf_hash_free(mht);
 }
@@ -1368,46 +1406,49 @@ mf_hash_free_all(mf_hashtab_T *mht)
     static mf_hashitem_T *
 mf_hash_find(mf_hashtab_T *mht, blocknr_T key)
 {
+    long_u	    idx = MHT_HASH(mht, key);
     mf_hashitem_T   *mhi;
 
-    mhi = mht->mht_buckets[key & mht->mht_mask];
-    while (mhi != NULL && mhi->mhi_key != key)
-	mhi = mhi->mhi_next;
+    // There always is an unused slot, this loop ends.
+    while ((mhi = mht->mht_buckets[idx]) != NULL && mhi->mhi_key != key)
+	idx = (idx + 1) & mht->mht_mask;
 
     return mhi;
 }
 
 /*
  * Add item "mhi" to hashtable "mht".
- * "mhi" must not be NULL.
+ * "mhi" must not be NULL and its key must not be in the hashtable yet.
+ * Returns FAIL when the hashtable is full and can't grow.
  */
-    static void
+    static int
 mf_hash_add_item(mf_hashtab_T *mht, mf_hashitem_T *mhi)
 {
     long_u	    idx;
 
-    idx = mhi->mhi_key & mht->mht_mask;
-    mhi->mhi_next = mht->mht_buckets[idx];
-    mhi->mhi_prev = NULL;
-    if (mhi->mhi_next != NULL)
-	mhi->mhi_next->mhi_prev = mhi;
-    mht->mht_buckets[idx] = mhi;
-
-    mht->mht_count++;
-
     /*
-     * Grow hashtable when we have more thank 2^MHT_LOG_LOAD_FACTOR
-     * items per bucket on average
+     * Grow hashtable when more than half of the slots would be used.  Keep
+     * trying when it is full, at least one slot must remain unused.
      */
-    if (mht->mht_fixed == 0
-	&& (mht->mht_count >> MHT_LOG_LOAD_FACTOR) > mht->mht_mask)
+    if ((mht->mht_fixed == 0 || mht->mht_count + 1 > mht->mht_mask)
+	    && (mht->mht_count + 1) * 2 > mht->mht_mask + 1)
     {
 	if (mf_hash_grow(mht) == FAIL)
 	{
 	    // stop trying to grow after first failure to allocate memory
 	    mht->mht_fixed = 1;
+	    if (mht->mht_count + 1 > mht->mht_mask)
+		return FAIL;
 	}
     }
+
+    idx = MHT_HASH(mht, mhi->mhi_key);
+    while (mht->mht_buckets[idx] != NULL)
+	idx = (idx + 1) & mht->mht_mask;
+    mht->mht_buckets[idx] = mhi;
+    mht->mht_count++;
+
+    return OK;
 }
 
 /*
@@ -1417,13 +1458,29 @@ mf_hash_add_item(mf_hashtab_T *mht, mf_hashitem_T *mhi)
     static void
 mf_hash_rem_item(mf_hashtab_T *mht, mf_hashitem_T *mhi)
 {
-    if (mhi->mhi_prev == NULL)
-	mht->mht_buckets[mhi->mhi_key & mht->mht_mask] = mhi->mhi_next;
-    else
-	mhi->mhi_prev->mhi_next = mhi->mhi_next;
+    long_u	    idx = MHT_HASH(mht, mhi->mhi_key);
+    long_u	    next;
+    long_u	    home;
+
+    while (mht->mht_buckets[idx] != mhi)
+	idx = (idx + 1) & mht->mht_mask;
 
-    if (mhi->mhi_next != NULL)
-	mhi->mhi_next->mhi_prev = mhi->mhi_prev;
+    /*
+     * Move items that come later in the same run of used slots back into
+     * the freed slot, unless they would be before their home slot then.
+     * This way there is no need to mark deleted slots.
+     */
+    for (next = (idx + 1) & mht->mht_mask; mht->mht_buckets[next] != NULL;
+					    next = (next + 1) & mht->mht_mask)
+    {
+	home = MHT_HASH(mht, mht->mht_buckets[next]->mhi_key);
+	if (((next - home) & mht->mht_mask) >= ((next - idx) & mht->mht_mask))
+	{
+	    mht->mht_buckets[idx] = mht->mht_buckets[next];
+	    idx = next;
+	}
+    }
+    mht->mht_buckets[idx] = NULL;
 
     mht->mht_count--;
 
@@ -1432,71 +1489,40 @@ mf_hash_rem_item(mf_hashtab_T *mht, mf_hashitem_T *mhi)
 }
 
 /*
- * Increase number of buckets in the hashtable by MHT_GROWTH_FACTOR and
+ * Increase number of slots in the hashtable by MHT_GROWTH_FACTOR and
  * rehash items.
  * Returns FAIL when out of memory.
  */
     static int
 mf_hash_grow(mf_hashtab_T *mht)
 {
-    long_u	    i, j;
-    int		    shift;
-    mf_hashitem_T   *mhi;
-    mf_hashitem_T   *tails[MHT_GROWTH_FACTOR];
+    long_u	    i;
+    long_u	    idx;
+    long_u	    old_mask = mht->mht_mask;
+    mf_hashitem_T   **old_buckets = mht->mht_buckets;
     mf_hashitem_T   **buckets;
+    mf_hashitem_T   *mhi;
     size_t	    size;
 
-    size = (mht->mht_mask + 1) * MHT_GROWTH_FACTOR * sizeof(void *);
+    size = (old_mask + 1) * MHT_GROWTH_FACTOR * sizeof(void *);
     buckets = lalloc_clear(size, FALSE);
     if (buckets == NULL)
 	return FAIL;
 
-    shift = 0;
-    while ((mht->mht_mask >> shift) != 0)
-	shift++;
-
-    for (i = 0; i <= mht->mht_mask; i++)
-    {
-	/*
-	 * Traverse the items in the i-th original bucket and move them into
-	 * MHT_GROWTH_FACTOR new buckets, preserving their relative order
-	 * within each new bucket.  Preserving the order is important because
-	 * mf_get() tries to keep most recently used items at the front of
-	 * each bucket.
-	 *
-	 * Here we strongly rely on the fact the hashes are computed modulo
-	 * a power of two.
-	 */
-
-	CLEAR_FIELD(tails);
+    mht->mht_buckets = buckets;
+    mht->mht_mask = (old_mask + 1) * MHT_GROWTH_FACTOR - 1;
 
-	for (mhi = mht->mht_buckets[i]; mhi != NULL; mhi = mhi->mhi_next)
+    for (i = 0; i <= old_mask; i++)
+	if ((mhi = old_buckets[i]) != NULL)
 	{
-	    j = (mhi->mhi_key >> shift) & (MHT_GROWTH_FACTOR - 1);
-	    if (tails[j] == NULL)
-	    {
-		buckets[i + (j << shift)] = mhi;
-		tails[j] = mhi;
-		mhi->mhi_prev = NULL;
-	    }
-	    else
-	    {
-		tails[j]->mhi_next = mhi;
-		mhi->mhi_prev = tails[j];
-		tails[j] = mhi;
-	    }
+	    idx = MHT_HASH(mht, mhi->mhi_key);
+	    while (buckets[idx] != NULL)
+		idx = (idx + 1) & mht->mht_mask;
+	    buckets[idx] = mhi;
 	}
 
-	for (j = 0; j < MHT_GROWTH_FACTOR; j++)
-	    if (tails[j] != NULL)
-		tails[j]->mhi_next = NULL;
-    }
-
-    if (mht->mht_buckets != mht->mht_small_buckets)
-	vim_free(mht->mht_buckets);
-
-    mht->mht_buckets = buckets;
-    mht->mht_mask = (mht->mht_mask + 1) * MHT_GROWTH_FACTOR - 1;
+    if (old_buckets != mht->mht_small_buckets)
+	vim_free(old_buckets);
 
     return OK;
 }
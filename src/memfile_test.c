@@ -48,10 +48,10 @@ test_mf_hash(void)
 	num_buckets = ht.mht_mask + 1;
 	assert(num_buckets > 0 && (num_buckets & (num_buckets - 1)) == 0);
 
-	// check load factor
-	assert(ht.mht_count <= (num_buckets << MHT_LOG_LOAD_FACTOR));
+	// check that at most half of the slots are used
+	assert(ht.mht_count * 2 <= num_buckets);
 
-	if (i < (MHT_INIT_SIZE << MHT_LOG_LOAD_FACTOR))
+	if (i <= MHT_INIT_SIZE / 2)
 	{
 	    // first expansion shouldn't have occurred yet
 	    assert(num_buckets == MHT_INIT_SIZE);
@@ -70,7 +70,7 @@ test_mf_hash(void)
 	item = LALLOC_CLEAR_ONE(mf_hashitem_T);
 	assert(item != NULL);
 	item->mhi_key = key;
-	mf_hash_add_item(&ht, item);
+	assert(mf_hash_add_item(&ht, item) == OK);
 
 	assert(mf_hash_find(&ht, key) == item);
 
@@ -78,7 +78,7 @@ test_mf_hash(void)
 	{
 	    // hash table was expanded
 	    assert(ht.mht_mask + 1 == num_buckets * MHT_GROWTH_FACTOR);
-	    assert(i + 1 == (num_buckets << MHT_LOG_LOAD_FACTOR));
+	    assert(i == num_buckets / 2);
 	}
     }
 
@@ -104,7 +104,7 @@ test_mf_hash(void)
 	    mf_hash_rem_item(&ht, item);
 	    assert(mf_hash_find(&ht, key) == NULL);
 
-	    mf_hash_add_item(&ht, item);
+	    assert(mf_hash_add_item(&ht, item) == OK);
 	    assert(mf_hash_find(&ht, key) == item);
 
 	    mf_hash_rem_item(&ht, item);
@@ -135,9 +135,56 @@ test_mf_hash(void)
     mf_hash_free_all(&ht);
 }
 
+/*
+ * Test mf_hash_*() functions with consecutive block numbers, as used for the
+ * blocks of a memfile.  Removing items must keep the others reachable.
+ */
+    static void
+test_mf_hash_consecutive(void)
+{
+    mf_hashtab_T   ht;
+    mf_hashitem_T  *item;
+    blocknr_T      key;
+
+    mf_hash_init(&ht);
+
+    for (key = -TEST_COUNT; key < TEST_COUNT; key++)
+    {
+	item = LALLOC_CLEAR_ONE(mf_hashitem_T);
+	assert(item != NULL);
+	item->mhi_key = key;
+	assert(mf_hash_add_item(&ht, item) == OK);
+    }
+    assert(ht.mht_count == 2 * TEST_COUNT);
+
+    // remove every third item
+    for (key = -TEST_COUNT; key < TEST_COUNT; key += 3)
+    {
+	item = mf_hash_find(&ht, key);
+	assert(item != NULL);
+	mf_hash_rem_item(&ht, item);
+	vim_free(item);
+    }
+
+    for (key = -TEST_COUNT; key < TEST_COUNT; key++)
+    {
+	item = mf_hash_find(&ht, key);
+	if ((key + TEST_COUNT) % 3 == 0)
+	    assert(item == NULL);
+	else
+	{
+	    assert(item != NULL);
+	    assert(item->mhi_key == key);
+	}
+    }
+
+    mf_hash_free_all(&ht);
+}
+
     int
 main(void)
 {
     test_mf_hash();
+    test_mf_hash_consecutive();
     return 0;
 }
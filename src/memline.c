@@ -296,6 +296,8 @@ ml_open(buf_T *buf)
 #ifdef FEAT_BYTEOFF
     buf->b_ml.ml_chunksize = NULL;
     buf->b_ml.ml_usedchunks = 0;
+    buf->b_ml.ml_chunktree = NULL;
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
 
     if (cmdmod.cmod_flags & CMOD_NOSWAPFILE)
@@ -885,6 +887,8 @@ ml_close(buf_T *buf, int del_file)
     vim_free(buf->b_ml.ml_stack);
 #ifdef FEAT_BYTEOFF
     VIM_CLEAR(buf->b_ml.ml_chunksize);
+    VIM_CLEAR(buf->b_ml.ml_chunktree);
+    buf->b_ml.ml_chunktree_valid = FALSE;
 #endif
     buf->b_ml.ml_mfp = NULL;
 
@@ -2890,6 +2894,57 @@ errorret:
     return buf->b_ml.ml_line_ptr;
 }
 
+/*
+ * Like ml_get_buf(), but the returned line stays valid when other lines are
+ * obtained, until ml_unpin_line() is called with "pin".  This avoids making a
+ * copy when two lines are needed at the same time.  The buffer must not be
+ * changed while the line is pinned.
+ * Returns NULL when out of memory.
+ */
+    char_u *
+ml_pin_line(buf_T *buf, linenr_T lnum, linepin_T *pin)
+{
+    char_u	*line = ml_get_buf(buf, lnum, FALSE);
+    bhdr_T	*hp = buf->b_ml.ml_locked;
+
+    pin->lp_hp = NULL;
+    pin->lp_alloc = NULL;
+    if ((buf->b_ml.ml_flags & (ML_LINE_DIRTY | ML_ALLOCATED)) == 0
+	    && hp != NULL
+	    && line >= hp->bh_data
+	    && line < hp->bh_data
+			 + (long)hp->bh_page_count * buf->b_ml.ml_mfp->mf_page_size)
+    {
+	// The line is in the data block, keep the block in memory.
+	pin->lp_hp = hp;
+	++hp->bh_pinned;
+    }
+    else if (buf->b_ml.ml_flags & (ML_LINE_DIRTY | ML_ALLOCATED))
+    {
+	// The line is in allocated memory that is freed when another line is
+	// obtained, need to make a copy.
+	pin->lp_alloc = vim_strnsave(line, ml_get_buf_len(buf, lnum));
+	line = pin->lp_alloc;
+    }
+    // else: an empty buffer or an error, "line" is a static string
+
+    return line;
+}
+
+/*
+ * Release a line obtained with ml_pin_line().
+ */
+    void
+ml_unpin_line(linepin_T *pin)
+{
+    if (pin->lp_hp != NULL)
+    {
+	--pin->lp_hp->bh_pinned;
+	pin->lp_hp = NULL;
+    }
+    VIM_CLEAR(pin->lp_alloc);
+}
+
 /*
  * Check if a line that was just obtained by a call to ml_get
  * is in allocated memory.
@@ -5773,6 +5828,124 @@ ml_crypt_prepare(memfile_T *mfp, off_T offset, int reading)
 # define MLCS_MAXL 800	// max no of lines in chunk
 # define MLCS_MINL 400   // should be half of MLCS_MAXL
 
+/*
+ * Besides the array of chunks a binary indexed (Fenwick) tree is kept in
+ * ml_chunktree[], entry "i" holding the sum of the line counts and sizes of
+ * the chunks "i - (i & -i)" up to "i - 1".  That allows for finding the chunk
+ * with a line number or byte offset in O(log n) steps, instead of adding up
+ * all the chunks before it.  Changing the size of a chunk updates the tree,
+ * splitting or joining chunks only marks it invalid, it is rebuilt when it is
+ * used the next time.
+ */
+    static void
+ml_chunktree_invalidate(buf_T *buf)
+{
+    buf->b_ml.ml_chunktree_valid = FALSE;
+}
+
+/*
+ * Make sure ml_chunktree[] is valid.  Return FAIL when out of memory.
+ */
+    static int
+ml_chunktree_build(buf_T *buf)
+{
+    chunksize_T	*tree;
+    int		n = buf->b_ml.ml_usedchunks;
+    int		i;
+    int		j;
+
+    if (buf->b_ml.ml_chunktree_valid)
+	return OK;
+    if (buf->b_ml.ml_chunktree == NULL)
+    {
+	buf->b_ml.ml_chunktree = ALLOC_MULT(chunksize_T,
+						   buf->b_ml.ml_numchunks + 1);
+	if (buf->b_ml.ml_chunktree == NULL)
+	    return FAIL;
+    }
+    tree = buf->b_ml.ml_chunktree;
+    mch_memmove(tree + 1, buf->b_ml.ml_chunksize, n * sizeof(chunksize_T));
+    for (i = 1; i <= n; ++i)
+    {
+	j = i + (i & -i);
+	if (j <= n)
+	{
+	    tree[j].mlcs_numlines += tree[i].mlcs_numlines;
+	    tree[j].mlcs_totalsize += tree[i].mlcs_totalsize;
+	}
+    }
+    buf->b_ml.ml_chunktree_valid = TRUE;
+    return OK;
+}
+
+/*
+ * Add "numlines" and "size" to chunk "ix" in ml_chunktree[], if it is valid.
+ */
+    static void
+ml_chunktree_update(buf_T *buf, int ix, int numlines, long size)
+{
+    int	    i;
+
+    if (!buf->b_ml.ml_chunktree_valid)
+	return;
+    for (i = ix + 1; i <= buf->b_ml.ml_usedchunks; i += (i & -i))
+    {
+	buf->b_ml.ml_chunktree[i].mlcs_numlines += numlines;
+	buf->b_ml.ml_chunktree[i].mlcs_totalsize += size;
+    }
+}
+
+/*
+ * Find the chunk containing line "lnum" (when not zero) or byte "offset".
+ * The last chunk is returned when going beyond it.
+ * "*linep" is set to the first line in the chunk and "*sizep" to the size of
+ * the chunks before it, including a CR per line when "ffdos" is TRUE.
+ * Returns the chunk index, -1 when the tree is not available.
+ */
+    static int
+ml_chunktree_find(
+    buf_T	*buf,
+    linenr_T	lnum,
+    long	offset,
+    int		ffdos,
+    linenr_T	*linep,
+    long	*sizep)
+{
+    chunksize_T	*tree;
+    int		n = buf->b_ml.ml_usedchunks - 1;  // last chunk never qualifies
+    int		ix = 0;
+    int		step;
+    linenr_T	lines = 0;
+    long	size = 0;
+    long	val;
+
+    if (ml_chunktree_build(buf) == FAIL)
+	return -1;
+    tree = buf->b_ml.ml_chunktree;
+
+    for (step = 1; step * 2 <= n; step *= 2)
+	;
+    for ( ; step > 0; step /= 2)
+    {
+	if (ix + step > n)
+	    continue;
+	if (lnum != 0)
+	    val = lines + tree[ix + step].mlcs_numlines;
+	else
+	    val = size + tree[ix + step].mlcs_totalsize
+			  + (long)ffdos * (lines + tree[ix + step].mlcs_numlines);
+	if (val < (lnum != 0 ? (long)lnum : offset))
+	{
+	    ix += step;
+	    lines += tree[ix].mlcs_numlines;
+	    size += tree[ix].mlcs_totalsize;
+	}
+    }
+    *linep = lines + 1;
+    *sizep = size + (long)ffdos * lines;
+    return ix;
+}
+
 /*
  * Keep information for finding byte offset of a line, updtype may be one of:
  * ML_CHNK_ADDLINE: Add len to parent chunk, possibly splitting it
@@ -5821,6 +5994,7 @@ ml_updatechunk(
 	/*
 	 * First line in empty buffer from ml_flush_line() -- reset
 	 */
+	ml_chunktree_invalidate(buf);
 	buf->b_ml.ml_usedchunks = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_numlines = 1;
 	buf->b_ml.ml_chunksize[0].mlcs_totalsize = (long)buf->b_ml.ml_line_len;
@@ -5834,11 +6008,14 @@ ml_updatechunk(
     if (buf != ml_upd_lastbuf || line != ml_upd_lastline + 1
 	    || updtype != ML_CHNK_ADDLINE)
     {
-	for (curline = 1, curix = 0;
-	     curix < buf->b_ml.ml_usedchunks - 1
-	     && line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines;
-	     curix++)
-	    curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
+	curix = ml_chunktree_find(buf, line, 0L, FALSE, &curline, &size);
+	if (curix < 0)
+	    for (curline = 1, curix = 0;
+		 curix < buf->b_ml.ml_usedchunks - 1
+		 && line >= curline
+				 + buf->b_ml.ml_chunksize[curix].mlcs_numlines;
+		 curix++)
+		curline += buf->b_ml.ml_chunksize[curix].mlcs_numlines;
     }
     else if (curix < buf->b_ml.ml_usedchunks - 1
 	      && line >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines)
@@ -5852,15 +6029,21 @@ ml_updatechunk(
     if (updtype == ML_CHNK_DELLINE)
 	len = -len;
     curchnk->mlcs_totalsize += len;
+    if (updtype == ML_CHNK_UPDLINE)
+	ml_chunktree_update(buf, curix, 0, len);
     if (updtype == ML_CHNK_ADDLINE)
     {
 	curchnk->mlcs_numlines++;
+	ml_chunktree_update(buf, curix, 1, len);
 
 	// May resize here so we don't have to do it in both cases below
 	if (buf->b_ml.ml_usedchunks + 1 >= buf->b_ml.ml_numchunks)
 	{
 	    chunksize_T *t_chunksize = buf->b_ml.ml_chunksize;
 
+	    // the tree must grow as well, it is allocated again later
+	    VIM_CLEAR(buf->b_ml.ml_chunktree);
+	    ml_chunktree_invalidate(buf);
 	    buf->b_ml.ml_numchunks = buf->b_ml.ml_numchunks * 3 / 2;
 	    buf->b_ml.ml_chunksize = vim_realloc(buf->b_ml.ml_chunksize,
 			    sizeof(chunksize_T) * buf->b_ml.ml_numchunks);
@@ -5881,6 +6064,7 @@ ml_updatechunk(
 	    int	    text_end;
 	    int	    linecnt;
 
+	    ml_chunktree_invalidate(buf);
 	    mch_memmove(buf->b_ml.ml_chunksize + curix + 1,
 			buf->b_ml.ml_chunksize + curix,
 			(buf->b_ml.ml_usedchunks - curix) *
@@ -5953,6 +6137,7 @@ ml_updatechunk(
 	     * We are in the last chunk and it is cheap to create a new one
 	     * after this. Do it now to avoid the loop above later on
 	     */
+	    ml_chunktree_invalidate(buf);
 	    curchnk = buf->b_ml.ml_chunksize + curix + 1;
 	    buf->b_ml.ml_usedchunks++;
 	    if (line == buf->b_ml.ml_line_count)
@@ -5989,6 +6174,7 @@ ml_updatechunk(
     else if (updtype == ML_CHNK_DELLINE)
     {
 	curchnk->mlcs_numlines--;
+	ml_chunktree_update(buf, curix, -1, len);
 	ml_upd_lastbuf = NULL;   // Force recalc of curix & curline
 	if (curix < buf->b_ml.ml_usedchunks - 1
 		&& curchnk->mlcs_numlines + curchnk[1].mlcs_numlines
@@ -5999,6 +6185,7 @@ ml_updatechunk(
 	}
 	else if (curix == 0 && curchnk->mlcs_numlines <= 0)
 	{
+	    ml_chunktree_invalidate(buf);
 	    buf->b_ml.ml_usedchunks--;
 	    mch_memmove(buf->b_ml.ml_chunksize, buf->b_ml.ml_chunksize + 1,
 			buf->b_ml.ml_usedchunks * sizeof(chunksize_T));
@@ -6012,6 +6199,7 @@ ml_updatechunk(
 	}
 
 	// Collapse chunks
+	ml_chunktree_invalidate(buf);
 	curchnk[-1].mlcs_numlines += curchnk->mlcs_numlines;
 	curchnk[-1].mlcs_totalsize += curchnk->mlcs_totalsize;
 	buf->b_ml.ml_usedchunks--;
@@ -6071,6 +6259,14 @@ ml_find_line_or_offset(buf_T *buf, linenr_T lnum, long *offp)
      */
     curline = 1;
     curix = size = 0;
+    if ((lnum == 0) != (offset == 0))
+	curix = ml_chunktree_find(buf, lnum, offset, ffdos && offset != 0,
+							      &curline, &size);
+    if (curix < 0)
+    {
+	curline = 1;
+	curix = size = 0;
+    }
     while (curix < buf->b_ml.ml_usedchunks - 1
 	    && ((lnum != 0
 	     && lnum >= curline + buf->b_ml.ml_chunksize[curix].mlcs_numlines)
@@ -3256,7 +3256,10 @@ nv_clear(cmdarg_T *cap)
 	win_T *wp;
 
 	FOR_ALL_WINDOWS(wp)
+	{
 	    wp->w_s->b_syn_slow = FALSE;
+	    wp->w_s->b_syn_ahead_slow = FALSE;
+	}
     }
 # endif
 #endif
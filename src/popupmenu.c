@@ -1566,8 +1566,31 @@ pum_set_selected(int n, int repeat UNUSED)
 pum_undisplay(void)
 {
     pum_free_bg();
+    if (pum_array != NULL
+#ifdef FEAT_RIGHTLEFT
+	    && !pum_rl
+#endif
+	    )
+    {
+	int	extra_left = pum_border + (pum_margin && pum_border ? 1 : 0);
+	int	extra_right = extra_left + (pum_shadow ? 2 : 0);
+	int	extra_above = pum_border;
+	int	extra_below = pum_border + (pum_shadow ? 1 : 0);
+
+	// Only redraw the window lines that were below the menu, same area
+	// as used by pum_under_menu().  Popups may have been covered too.
+	redraw_win_lines_in_area(pum_row - extra_above,
+		pum_col - 1 - extra_left,
+		pum_height + extra_above + extra_below,
+		pum_width + pum_scrollbar + extra_left + extra_right + 1);
+	redraw_later(UPD_VALID);
+#ifdef FEAT_PROP_POPUP
+	popup_redraw_all();
+#endif
+    }
+    else
+	redraw_all_later(UPD_NOT_VALID);
     pum_array = NULL;
-    redraw_all_later(UPD_NOT_VALID);
     redraw_tabline = TRUE;
 #if defined(FEAT_TABPANEL)
     redraw_tabpanel = TRUE;
@@ -45,9 +45,12 @@ static void may_start_message_win_timer(win_T *wp);
 
 static int popup_on_cmdline = FALSE;
 
+// Set when a popup appeared, disappeared or moved, the position of the popups
+// needs to be recomputed.
+static int popup_position_refresh = FALSE;
+
 static void popup_adjust_position(win_T *wp);
-static void redraw_under_popup_area(int winrow, int wincol, int height,
-	int width, int leftoff);
+static void popup_redraw_win(win_T *wp);
 
 /*
  * Get option value for "key", which is "line" or "col".
@@ -431,7 +434,7 @@ popup_handle_scrollbar_click(win_T *wp, int row, int col)
 	}
     }
     popup_set_firstline(wp);
-    redraw_win_later(wp, UPD_NOT_VALID);
+    popup_redraw_win(wp);
 }
 
 #if defined(FEAT_TIMERS)
@@ -706,7 +709,7 @@ popup_highlight_curline(win_T *wp)
 
 	sign_place(&sign_id, (char_u *)"PopUpMenu", sign_name,
 			       wp->w_buffer, wp->w_cursor.lnum, SIGN_DEF_PRIO);
-	redraw_win_later(wp, UPD_NOT_VALID);
+	popup_redraw_win(wp);
     }
     else
 	sign_undefine_by_name(sign_name, FALSE);
@@ -1256,6 +1259,55 @@ popup_extra_width(win_T *wp)
 	    + wp->w_has_scrollbar;
 }
 
+/*
+ * Redraw only popup "wp" itself.  Not using redraw_win_later(), with
+ * UPD_NOT_VALID it would set the global must_redraw and all windows would be
+ * redrawn.
+ */
+    static void
+popup_redraw_win(win_T *wp)
+{
+    wp->w_redr_type = UPD_NOT_VALID;
+    wp->w_lines_valid = 0;
+    if (must_redraw < UPD_VALID)
+	must_redraw = UPD_VALID;
+}
+
+/*
+ * Called when popup "wp" appears, disappears or moves.  Instead of redrawing
+ * all windows the popup mask is recomputed, windows below the popup then only
+ * redraw the screen lines where the mask changed.  A popup with opacity is
+ * not in the mask, the window lines under it are redrawn.
+ */
+    static void
+popup_redraw_below(win_T *wp)
+{
+    popup_redraw_win(wp);
+    // The intro message is not in the windows, clear it by redrawing all.
+    if (can_show_intro_message())
+	redraw_all_later(UPD_NOT_VALID);
+    else if ((wp->w_popup_flags & POPF_OPACITY) && wp->w_popup_blend > 0)
+	redraw_win_lines_in_area(wp->w_winrow, wp->w_wincol,
+			popup_height(wp), popup_width(wp) - wp->w_popup_leftoff);
+    popup_mask_refresh = TRUE;
+    popup_position_refresh = TRUE;
+}
+
+/*
+ * Initialize popup window "wp" to display buffer "buf".
+ * win_init_empty() uses redraw_win_later(), which would cause all windows to
+ * be redrawn.  Only the popup itself needs to be drawn, the caller must use
+ * popup_redraw_below().
+ */
+    static void
+popup_init_win(win_T *wp, buf_T *buf)
+{
+    int		save_must_redraw = must_redraw;
+
+    win_init_popup_win(wp, buf);
+    must_redraw = save_must_redraw;
+}
+
 /*
  * Adjust the position and size of the popup to fit on the screen.
  */
@@ -1288,6 +1340,8 @@ popup_adjust_position(win_T *wp)
     int		org_height = wp->w_height;
     int		org_leftcol = wp->w_leftcol;
     int		org_leftoff = wp->w_popup_leftoff;
+    int		org_popup_height = popup_height(wp);
+    int		org_popup_width = popup_width(wp);
     int		minwidth, minheight;
     int		maxheight = Rows;
     int		wantline = wp->w_wantline;  // adjusted for textprop
@@ -1775,10 +1829,14 @@ popup_adjust_position(win_T *wp)
 	    || org_width != wp->w_width
 	    || org_height != wp->w_height)
     {
-	redraw_win_later(wp, UPD_NOT_VALID);
+	popup_redraw_below(wp);
+	// A popup with opacity is not in the popup mask, also redraw the
+	// window lines at the old position.
+	if ((wp->w_popup_flags & POPF_OPACITY) && wp->w_popup_blend > 0)
+	    redraw_win_lines_in_area(org_winrow, org_wincol,
+			       org_popup_height, org_popup_width - org_leftoff);
 	if (wp->w_popup_flags & POPF_ON_CMDLINE)
 	    clear_cmdline = TRUE;
-	popup_mask_refresh = TRUE;
     }
 }
 
@@ -2364,7 +2422,7 @@ popup_create(typval_T *argvars, typval_T *rettv, create_type_T type)
     {
 	// use existing buffer
 	new_buffer = FALSE;
-	win_init_popup_win(wp, buf);
+	popup_init_win(wp, buf);
 	set_local_options_default(wp, FALSE);
 	swap_exists_action = SEA_READONLY;
 	buffer_ensure_loaded(buf);
@@ -2382,7 +2440,7 @@ popup_create(typval_T *argvars, typval_T *rettv, create_type_T type)
 	}
 	ml_open(buf);
 
-	win_init_popup_win(wp, buf);
+	popup_init_win(wp, buf);
 
 	set_local_options_default(wp, TRUE);
 	set_string_option_direct_in_buf(buf, (char_u *)"buftype", -1,
@@ -2585,8 +2643,7 @@ popup_create(typval_T *argvars, typval_T *rettv, create_type_T type)
 
     wp->w_vsep_width = 0;
 
-    redraw_all_later(UPD_NOT_VALID);
-    popup_mask_refresh = TRUE;
+    popup_redraw_below(wp);
 
 #ifdef FEAT_TERMINAL
     // When running a terminal in the popup it becomes the current window.
@@ -3034,9 +3091,8 @@ popup_hide(win_T *wp)
     // Do not decrement b_nwindows, we still reference the buffer.
     if (wp->w_winrow + popup_height(wp) >= cmdline_row)
 	clear_cmdline = TRUE;
-    redraw_all_later(UPD_NOT_VALID);
+    popup_redraw_below(wp);
     status_redraw_all();
-    popup_mask_refresh = TRUE;
 }
 
 /*
@@ -3067,8 +3123,7 @@ popup_show(win_T *wp)
 	return;
 
     wp->w_popup_flags &= ~POPF_HIDDEN;
-    redraw_all_later(UPD_NOT_VALID);
-    popup_mask_refresh = TRUE;
+    popup_redraw_below(wp);
 }
 
 /*
@@ -3143,14 +3198,9 @@ f_popup_settext(typval_T *argvars, typval_T *rettv UNUSED)
 
     popup_set_buffer_text(wp->w_buffer, argvars[1]);
 
-    // Redraw the popup window without triggering a full screen redraw.
-    // Using redraw_win_later() with UPD_NOT_VALID would set the global
-    // must_redraw, causing may_update_popup_mask() to refresh the mask and
-    // redraw windows behind the popup, resulting in flickering.
-    wp->w_redr_type = UPD_NOT_VALID;
-    wp->w_lines_valid = 0;
-    if (must_redraw < UPD_VALID)
-	must_redraw = UPD_VALID;
+    // Redraw the popup window without triggering a full screen redraw, that
+    // would cause flickering of the windows behind the popup.
+    popup_redraw_win(wp);
     popup_adjust_position(wp);
 
 #ifdef FEAT_PROP_POPUP
@@ -3160,8 +3210,8 @@ f_popup_settext(typval_T *argvars, typval_T *rettv UNUSED)
 		|| old_popup_height != popup_height(wp)
 		|| old_popup_width != popup_width(wp)
 		|| old_popup_leftoff != wp->w_popup_leftoff))
-	redraw_under_popup_area(old_winrow, old_wincol,
-		old_popup_height, old_popup_width, old_popup_leftoff);
+	redraw_win_lines_in_area(old_winrow, old_wincol,
+		old_popup_height, old_popup_width - old_popup_leftoff);
 #endif
 }
 
@@ -3202,12 +3252,12 @@ f_popup_setbuf(typval_T *argvars, typval_T *rettv UNUSED)
     if (wp->w_buffer != buf)
     {
 	wp->w_buffer->b_nwindows--;
-	win_init_popup_win(wp, buf);
+	popup_init_win(wp, buf);
 	set_local_options_default(wp, FALSE);
 	swap_exists_action = SEA_READONLY;
 	buffer_ensure_loaded(buf);
 	swap_exists_action = SEA_NONE;
-	redraw_win_later(wp, UPD_NOT_VALID);
+	popup_redraw_below(wp);
 	popup_adjust_position(wp);
     }
     rettv->vval.v_number = VVAL_TRUE;
@@ -3220,6 +3270,7 @@ popup_free(win_T *wp)
     wp->w_buffer->b_locked = FALSE;
     if (wp->w_winrow + popup_height(wp) >= cmdline_row)
 	clear_cmdline = TRUE;
+    popup_redraw_below(wp);
     win_free_popup(wp);
 
 #ifdef HAS_MESSAGE_WINDOW
@@ -3227,9 +3278,7 @@ popup_free(win_T *wp)
 	message_win = NULL;
 #endif
 
-    redraw_all_later(UPD_NOT_VALID);
     status_redraw_all();
-    popup_mask_refresh = TRUE;
 }
 
     static void
@@ -3347,49 +3396,6 @@ close_all_popups(int force)
 	    return;
 }
 
-/*
- * Force windows under a popup area to redraw.
- */
-    static void
-redraw_under_popup_area(int winrow, int wincol, int height, int width, int leftoff)
-{
-    int	    r;
-
-    for (r = winrow; r < winrow + height && r < screen_Rows; ++r)
-    {
-	int	    c;
-	win_T	    *prev_twp = NULL;
-
-	if (r >= cmdline_row)
-	{
-	    clear_cmdline = TRUE;
-	    continue;
-	}
-
-	for (c = wincol; c < wincol + width - leftoff && c < screen_Columns; ++c)
-	{
-	    int	    line_cp = r;
-	    int	    col_cp = c;
-	    win_T   *twp;
-
-	    twp = mouse_find_win(&line_cp, &col_cp, IGNORE_POPUP);
-	    if (twp != NULL && twp != prev_twp)
-	    {
-		prev_twp = twp;
-		if (line_cp < twp->w_height)
-		{
-		    linenr_T lnum;
-
-		    (void)mouse_comp_pos(twp, &line_cp, &col_cp, &lnum, NULL);
-		    redrawWinline(twp, lnum);
-		}
-		else if (line_cp == twp->w_height)
-		    twp->w_redr_status = TRUE;
-	    }
-	}
-    }
-}
-
 /*
  * popup_move({id}, {options})
  */
@@ -3399,13 +3405,6 @@ f_popup_move(typval_T *argvars, typval_T *rettv UNUSED)
     dict_T	*dict;
     int		id;
     win_T	*wp;
-    int		old_winrow;
-    int		old_wincol;
-    int		old_height;
-    int		old_width;
-    int		old_popup_height;
-    int		old_popup_width;
-    int		old_popup_leftoff;
 
     if (in_vim9script()
 	    && (check_for_number_arg(argvars, 0) == FAIL
@@ -3421,35 +3420,11 @@ f_popup_move(typval_T *argvars, typval_T *rettv UNUSED)
 	return;
     dict = argvars[1].vval.v_dict;
 
-    // Save old position for redrawing
-    old_winrow = wp->w_winrow;
-    old_wincol = wp->w_wincol;
-    old_height = wp->w_height;
-    old_width = wp->w_width;
-    old_popup_height = popup_height(wp);
-    old_popup_width = popup_width(wp);
-    old_popup_leftoff = wp->w_popup_leftoff;
-
     apply_move_options(wp, dict);
 
     if (wp->w_winrow + wp->w_height >= cmdline_row)
 	clear_cmdline = TRUE;
     popup_adjust_position(wp);
-
-    // Redraw the popup at the new position; for opaque popups, the
-    // diff-based popup mask update in may_update_popup_mask() will handle
-    // redrawing the affected lines in regular windows to clear the old
-    // position.  Transparent popups don't participate in popup_mask, so
-    // we need to manually mark the old area's lines for redraw.
-    if (old_winrow != wp->w_winrow || old_wincol != wp->w_wincol
-	    || old_height != wp->w_height || old_width != wp->w_width)
-    {
-	redraw_win_later(wp, UPD_NOT_VALID);
-
-	if ((wp->w_popup_flags & POPF_OPACITY) && wp->w_popup_blend > 0)
-	    redraw_under_popup_area(old_winrow, old_wincol,
-		    old_popup_height, old_popup_width, old_popup_leftoff);
-    }
 }
 
 /*
@@ -3544,31 +3519,19 @@ f_popup_setoptions(typval_T *argvars, typval_T *rettv UNUSED)
 	}
 
     if (need_reposition)
-    {
-	redraw_win_later(wp, UPD_NOT_VALID);
-	popup_mask_refresh = TRUE;
-    }
+	popup_redraw_below(wp);
     else if (need_redraw)
-    {
 	// Only content changed (e.g. firstline, highlight): redraw the
 	// popup window without updating the popup mask or triggering a
 	// full screen redraw.  This avoids flickering of windows behind
 	// the popup.
-	wp->w_redr_type = UPD_NOT_VALID;
-	wp->w_lines_valid = 0;
-	if (must_redraw < UPD_VALID)
-	    must_redraw = UPD_VALID;
-    }
+	popup_redraw_win(wp);
 
 #ifdef FEAT_PROP_POPUP
     // Force redraw if opacity value changed
     if (old_blend != wp->w_popup_blend)
-    {
-	redraw_win_later(wp, UPD_NOT_VALID);
-	// Also redraw windows below the popup
-	redraw_all_later(UPD_NOT_VALID);
-	popup_mask_refresh = TRUE;
-    }
+	// Also redraw the window lines below the popup
+	popup_redraw_below(wp);
 #endif
 
     // Always recalculate popup position/size: other options like border,
@@ -3584,8 +3547,8 @@ f_popup_setoptions(typval_T *argvars, typval_T *rettv UNUSED)
 		|| old_popup_height != popup_height(wp)
 		|| old_popup_width != popup_width(wp)
 		|| old_popup_leftoff != wp->w_popup_leftoff))
-	redraw_under_popup_area(old_winrow, old_wincol,
-		old_popup_height, old_popup_width, old_popup_leftoff);
+	redraw_win_lines_in_area(old_winrow, old_wincol,
+		old_popup_height, old_popup_width - old_popup_leftoff);
 #endif
 }
 
@@ -4338,6 +4301,10 @@ popup_need_position_adjust(win_T *wp)
     return wp->w_cursor.lnum != wp->w_popup_last_curline;
 }
 
+// Set when "popup_mask" changed, the screen may still show text of a popup
+// where there is none now, until the popups have been updated.
+static int popup_mask_changed = FALSE;
+
 // Cached array with max zindex of opacity popups covering each cell.
 // Allocated in may_update_popup_mask() when opacity popups exist.
 static short *opacity_zindex = NULL;
@@ -4479,6 +4446,11 @@ may_update_popup_mask(int type)
 	popup_mask_refresh = TRUE;
 	redraw_all_popups = TRUE;
     }
+    if (popup_position_refresh)
+    {
+	popup_position_refresh = FALSE;
+	redraw_all_popups = TRUE;
+    }
 
     // Check if any popup window buffer has changed and if any popup connected
     // to a text property has become visible.
@@ -4634,6 +4606,7 @@ may_update_popup_mask(int type)
 		if (popup_mask[off] != popup_mask_next[off])
 		{
 		    popup_mask[off] = popup_mask_next[off];
+		    popup_mask_changed = TRUE;
 
 		    if (line >= cmdline_row)
 		    {
@@ -4686,6 +4659,14 @@ may_update_popup_mask(int type)
 			    // check until the right side of the window.
 			    col_done = wp->w_wincol + wp->w_width - 1;
 			}
+			else
+			{
+			    // In the tabline or the tabpanel.
+			    redraw_tabline = TRUE;
+#if defined(FEAT_TABPANEL)
+			    redraw_tabpanel = TRUE;
+#endif
+			}
 		    }
 		}
 	    }
@@ -4697,6 +4678,31 @@ may_update_popup_mask(int type)
     update_popup_uses_mouse_move();
 }
 
+/*
+ * Return TRUE if the screen lines of window "wp" may show text of a popup,
+ * these can't be moved to another screen line.
+ */
+    int
+popup_may_cover_win(win_T *wp)
+{
+    int		row;
+    int		col;
+
+    if (popup_mask_changed || opacity_zindex != NULL)
+	return TRUE;
+    if (!popup_visible)
+	return FALSE;
+    if (popup_mask == NULL)
+	return TRUE;
+    for (row = W_WINROW(wp); row < W_WINROW(wp) + wp->w_height
+						  && row < screen_Rows; ++row)
+	for (col = wp->w_wincol; col < W_ENDCOL(wp)
+					       && col < screen_Columns; ++col)
+	    if (popup_mask[row * screen_Columns + col] != 0)
+		return TRUE;
+    return FALSE;
+}
+
 /*
  * If the current window is a popup and something relevant changed, recompute
  * the position and size.
@@ -4977,6 +4983,9 @@ update_popups(void (*win_update)(win_T *wp))
     // hide the cursor until redrawing is done.
     cursor_off();
 
+    // The windows below the popups have been updated.
+    popup_mask_changed = FALSE;
+
     // Find the window with the lowest zindex that hasn't been updated yet,
     // so that the window with a higher zindex is drawn later, thus goes on
     // top.
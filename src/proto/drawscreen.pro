@@ -25,6 +25,10 @@ void redraw_statuslines(void);
 void win_redraw_last_status(frame_T *frp);
 void redrawWinline(win_T *wp, linenr_T lnum);
 void redraw_win_range_later(win_T *wp, linenr_T first, linenr_T last);
+void redraw_win_lines_in_area(int row, int col, int height, int width);
 void f_redraw_listener_add(typval_T *argvars, typval_T *rettv);
 void f_redraw_listener_remove(typval_T *argvars, typval_T *rettv);
+void redrawstats_add_time(proftime_T *total, proftime_T *tm);
+void ex_redrawstats(exarg_T *eap);
+void f_redrawstats(typval_T *argvars, typval_T *rettv);
 /* vim: set ft=c : */
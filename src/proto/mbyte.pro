@@ -33,6 +33,7 @@ int utf_ptr2len(char_u *p);
 int utf_byte2len(int b);
 int utf_byte2len_zero(int b);
 int utf_ptr2len_len(char_u *p, int size);
+int utf_valid_len(char_u *p, int size);
 int utfc_ptr2len(char_u *p);
 int utfc_ptr2len_len(char_u *p, int size);
 int utf_char2len(int c);
@@ -55,6 +55,7 @@ void popup_check_cursor_pos(void);
 int popup_is_under_opacity(int row, int col);
 int popup_is_under_opacity_range(int row, int start_col, int end_col);
 void may_update_popup_mask(int type);
+int popup_may_cover_win(win_T *wp);
 void may_update_popup_position(void);
 int popup_get_base_screen_cell(int row, int col, schar_T *linep, int *attrp, u8char_T *ucp);
 void popup_set_base_screen_cell(int row, int col, schar_T line, int attr, u8char_T uc);
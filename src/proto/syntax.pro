@@ -1,6 +1,9 @@
 /* syntax.c */
 void syntax_start(win_T *wp, linenr_T lnum);
+int syn_parse_ahead(void);
 void syn_stack_free_all(synblock_T *block);
+void syn_stack_reload_save(buf_T *buf);
+void syn_stack_reload_restore(buf_T *buf, linenr_T lnum);
 void syn_stack_apply_changes(buf_T *buf);
 void syntax_end_parsing(win_T *wp, linenr_T lnum);
 int syntax_check_changed(linenr_T lnum);
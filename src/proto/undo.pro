@@ -2,6 +2,8 @@
 int u_save_cursor(void);
 int u_save(linenr_T top, linenr_T bot);
 int u_savesub(linenr_T lnum);
+int u_savesub_batch(linenr_T lnum, u_batch_T *ub);
+void u_savesub_batch_end(u_batch_T *ub);
 int u_inssub(linenr_T lnum);
 int u_savedel(linenr_T lnum, long nlines);
 int undo_allowed(void);
@@ -5,6 +5,7 @@ int has_patch(int n);
 void ex_version(exarg_T *eap);
 void list_in_columns(char_u **items, int size, int current);
 void list_version(void);
+int can_show_intro_message(void);
 void maybe_intro_message(void);
 void ex_intro(exarg_T *eap);
 /* vim: set ft=c : */
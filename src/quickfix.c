@@ -6412,6 +6412,116 @@ vgr_load_dummy_buf(
     return buf;
 }
 
+#define VGR_READ_SIZE	0x10000
+
+// Events triggered when loading and wiping out a dummy buffer.
+static event_T vgr_load_events[] = {
+    EVENT_BUFNEW, EVENT_BUFADD, EVENT_BUFREADCMD, EVENT_BUFREADPRE,
+    EVENT_BUFREADPOST, EVENT_BUFUNLOAD, EVENT_BUFDELETE, EVENT_BUFWIPEOUT
+};
+
+/*
+ * Return FALSE when file "fname" can't contain a match for "regmatch", because
+ * it doesn't contain the text that every match must contain.  This avoids
+ * loading a buffer for files without a match, which is slow.
+ * Returns TRUE when the file may match or when unsure.
+ */
+    static int
+vgr_file_may_match(char_u *fname, regmmatch_T *regmatch)
+{
+    char_u	*must;
+    size_t	mustlen;
+    int		ic;
+    stat_T	st;
+    int		fd;
+    char_u	*buf;
+    char_u	*p;
+    size_t	len = 0;
+    long	n;
+    int		first = TRUE;
+    int		may_match = TRUE;
+    int		i;
+
+    if (regmatch->regprog == NULL)
+	return TRUE;
+    must = vim_regprog_must_text(regmatch->regprog, regmatch->rmm_ic, &ic);
+    if (must == NULL)
+	return TRUE;
+
+    // Autocommands may change what is loaded, e.g. uncompress the file, and
+    // those for loading and unloading the buffer are expected to be triggered.
+    for (i = 0; i < (int)ARRAY_LENGTH(vgr_load_events); ++i)
+	if (has_autocmd(vgr_load_events[i], fname, NULL))
+	    return TRUE;
+
+    // Don't read from a device or fifo, it may block.
+    if (mch_stat((char *)fname, &st) < 0 || !S_ISREG(st.st_mode))
+	return TRUE;
+    fd = mch_open((char *)fname, O_RDONLY | O_EXTRA, 0);
+    if (fd < 0)
+	return TRUE;
+
+    mustlen = STRLEN(must);
+    buf = alloc(VGR_READ_SIZE + mustlen + 1);
+    if (buf != NULL)
+    {
+	for (;;)
+	{
+	    n = read_eintr(fd, buf + len, VGR_READ_SIZE);
+	    if (n <= 0)
+	    {
+		// End of the file without finding the text.
+		if (n == 0)
+		    may_match = FALSE;
+		break;
+	    }
+	    // An encrypted file can only be checked after decrypting.
+	    if (first && len + n >= 9 && STRNCMP(buf, "VimCrypt~", 9) == 0)
+		break;
+	    first = FALSE;
+
+	    // A NUL may be part of a UTF-16 or UCS-4 character, then the text
+	    // may be found after conversion.
+	    if (memchr(buf + len, NUL, n) != NULL)
+		break;
+	    len += n;
+	    buf[len] = NUL;
+
+	    if (!ic)
+	    {
+		if (strstr((char *)buf, (char *)must) != NULL)
+		    break;
+	    }
+	    else
+	    {
+		for (p = buf; p + mustlen <= buf + len; ++p)
+		{
+		    size_t k;
+
+		    for (k = 0; k < mustlen; ++k)
+			if (TOLOWER_ASC(p[k]) != TOLOWER_ASC(must[k]))
+			    break;
+		    if (k == mustlen)
+			break;
+		}
+		if (p + mustlen <= buf + len)
+		    break;
+	    }
+
+	    // Keep the end of the block, the text may continue in the next
+	    // block.
+	    if (len >= mustlen)
+	    {
+		mch_memmove(buf, buf + len - (mustlen - 1), mustlen - 1);
+		len = mustlen - 1;
+	    }
+	}
+	vim_free(buf);
+    }
+    close(fd);
+    return may_match;
+}
+
 /*
  * Check whether a quickfix/location list is valid. Autocmds may remove or
  * change a quickfix list when vimgrep is running. If the list is not found,
@@ -6736,6 +6846,12 @@ vgr_process_files(
 	buf = buflist_findname_exp(cmd_args->fnames[fi]);
 	if (buf == NULL || buf->b_ml.ml_mfp == NULL)
 	{
+	    // Skip a file that can't match without loading it.
+	    if ((cmd_args->flags & VGR_FUZZY) == 0
+		    && !vgr_file_may_match(cmd_args->fnames[fi],
+							 &cmd_args->regmatch))
+		continue;
+
 	    // Remember that a buffer with this name already exists.
 	    duplicate_name = (buf != NULL);
 	    using_dummy = TRUE;
@@ -434,6 +434,7 @@ static int	coll_get_char(void);
 static int	prog_magic_wrong(void);
 static int	cstrncmp(char_u *s1, char_u *s2, int *n);
 static char_u	*cstrchr(char_u *, int);
+static char_u	*reg_find_must(char_u *s, char_u *must, int mustlen);
 static int	re_mult_next(char *what);
 static int	reg_iswordc(int);
 #ifdef FEAT_EVAL
@@ -1125,12 +1126,29 @@ static void	cleanup_zsubexpr(void);
 static int	match_with_backref(linenr_T start_lnum, colnr_T start_col, linenr_T end_lnum, colnr_T end_col, int *bytelen);
 
 /*
- * Sometimes need to save a copy of a line.  Since alloc()/free() is very
- * slow, we keep one allocated piece of memory and only re-allocate it when
- * it's too small.  It's freed in bt_regexec_both() when finished.
+ * Structure used to save the current input state, when it needs to be
+ * restored after trying a match.  Used by reg_save() and reg_restore().
+ * Also stores the length of "backpos".
  */
-static char_u	*reg_tofree = NULL;
-static unsigned	reg_tofreelen;
+typedef struct
+{
+    union
+    {
+	char_u	*ptr;	// rex.input pointer, for single-line regexp
+	lpos_T	pos;	// rex.input pos, for multi-line regexp
+    } rs_u;
+    int		rs_len;
+} regsave_T;
+
+// struct to save start/end pointer/position in for \(\)
+typedef struct
+{
+    union
+    {
+	char_u	*ptr;
+	lpos_T	pos;
+    } se_u;
+} save_se_T;
 
 /*
  * Structure used to store the execution state of the regex engine.
@@ -1202,12 +1220,82 @@ typedef struct {
 
 #ifdef FEAT_SYN_HL
     int nfa_has_zsubexpr;   // NFA regexp has \z( ), set zsubexpr.
+#endif
+    int nfa_match;	    // whether a match has been found
+#ifdef FEAT_RELTIME
+    int *nfa_timed_out;	    // flag set when the timeout was reached
+#endif
+    save_se_T *nfa_endp;    // if not NULL match must end at this position
+    int nfa_ll_index;	    // 0 for first call to nfa_regmatch(), 1 for
+			    // recursive call
+
+    // State for the backtracking engine regexec.
+    // "regstack" and "backpos" are used by regmatch().  They are kept over
+    // calls to avoid invoking malloc() and free() often.
+    // "regstack" is a stack with regitem_T items, sometimes preceded by
+    // regstar_T or regbehind_T.
+    // "backpos" is a table with backpos_T for BACK.
+    garray_T	regstack;
+    garray_T	backpos;
+    regsave_T	behind_pos;
+
+#ifdef FEAT_SYN_HL
+    char_u	*reg_startzp[NSUBEXP];	// Workspace to mark beginning
+    char_u	*reg_endzp[NSUBEXP];	//   and end of \z(...\) matches
+    lpos_T	reg_startzpos[NSUBEXP];	// idem, beginning pos
+    lpos_T	reg_endzpos[NSUBEXP];	// idem, end pos
 #endif
 } regexec_T;
 
 static regexec_T	rex;
 static int		rex_in_use = FALSE;
 
+/*
+ * Start using "rex" for matching or substituting.
+ * When it is already in use the functions are called recursively, e.g. from
+ * an expression in a substitute string.  Then the whole state of the outer
+ * call is saved in "save" and the nested call gets its own stacks.
+ * Returns the value to pass to rex_leave().
+ */
+    static int
+rex_enter(regexec_T *save)
+{
+    int		was_in_use = rex_in_use;
+
+    if (was_in_use)
+    {
+	*save = rex;
+	ga_init(&rex.regstack);
+	ga_init(&rex.backpos);
+	rex.nfa_endp = NULL;
+	rex.nfa_ll_index = 0;
+    }
+    rex_in_use = TRUE;
+    return was_in_use;
+}
+
+/*
+ * Done using "rex", restore the state saved by rex_enter().
+ */
+    static void
+rex_leave(regexec_T *save, int was_in_use)
+{
+    rex_in_use = was_in_use;
+    if (was_in_use)
+    {
+	ga_clear(&rex.regstack);
+	ga_clear(&rex.backpos);
+	rex = *save;
+    }
+}
+
+#ifdef FEAT_PROFILE
+// Number of items tried by the backtracking engine and number of states
+// handled by the NFA engine.  Used for ":regprofile".
+static long	regprof_bt_steps = 0;
+static long	regprof_nfa_states = 0;
+#endif
+
 /*
  * Return TRUE if character 'c' is included in 'iskeyword' option for
  * "reg_buf" buffer.
@@ -1332,13 +1420,6 @@ reg_getline_len(linenr_T lnum)
     return length;
 }
 
-#ifdef FEAT_SYN_HL
-static char_u	*reg_startzp[NSUBEXP];	// Workspace to mark beginning
-static char_u	*reg_endzp[NSUBEXP];	//   and end of \z(...\) matches
-static lpos_T	reg_startzpos[NSUBEXP];	// idem, beginning pos
-static lpos_T	reg_endzpos[NSUBEXP];	// idem, end pos
-#endif
-
 // TRUE if using multi-line regexp.
 #define REG_MULTI	(rex.reg_match == NULL)
 
@@ -1541,13 +1622,13 @@ cleanup_zsubexpr(void)
     if (REG_MULTI)
     {
 	// Use 0xff to set lnum to -1
-	vim_memset(reg_startzpos, 0xff, sizeof(lpos_T) * NSUBEXP);
-	vim_memset(reg_endzpos, 0xff, sizeof(lpos_T) * NSUBEXP);
+	vim_memset(rex.reg_startzpos, 0xff, sizeof(lpos_T) * NSUBEXP);
+	vim_memset(rex.reg_endzpos, 0xff, sizeof(lpos_T) * NSUBEXP);
     }
     else
     {
-	vim_memset(reg_startzp, 0, sizeof(char_u *) * NSUBEXP);
-	vim_memset(reg_endzp, 0, sizeof(char_u *) * NSUBEXP);
+	vim_memset(rex.reg_startzp, 0, sizeof(char_u *) * NSUBEXP);
+	vim_memset(rex.reg_endzp, 0, sizeof(char_u *) * NSUBEXP);
     }
     rex.need_clear_zsubexpr = FALSE;
 }
@@ -1583,40 +1664,41 @@ match_with_backref(
     colnr_T	ccol = start_col;
     int		len;
     char_u	*p;
+    linepin_T	pin;
+    colnr_T	input_col;
+    int		differ;
 
     if (bytelen != NULL)
 	*bytelen = 0;
     for (;;)
     {
-	// Since getting one line may invalidate the other, need to make copy.
-	// Slow!
-	if (rex.line != reg_tofree)
+	// Get the line to compare with.  Since getting one line may invalidate
+	// the other, pin it and get the current line again.
+	input_col = (colnr_T)(rex.input - rex.line);
+	if (rex.reg_firstlnum + clnum >= 1 && clnum <= rex.reg_maxline)
 	{
-	    len = (int)STRLEN(rex.line);
-	    if (reg_tofree == NULL || len >= (int)reg_tofreelen)
-	    {
-		len += 50;	// get some extra
-		vim_free(reg_tofree);
-		reg_tofree = alloc(len);
-		if (reg_tofree == NULL)
-		    return RA_FAIL; // out of memory!
-		reg_tofreelen = len;
-	    }
-	    STRCPY(reg_tofree, rex.line);
-	    rex.input = reg_tofree + (rex.input - rex.line);
-	    rex.line = reg_tofree;
+	    p = ml_pin_line(rex.reg_buf, rex.reg_firstlnum + clnum, &pin);
+	    if (p == NULL)
+		return RA_FAIL; // out of memory!
+	}
+	else
+	{
+	    p = reg_getline(clnum);
+	    pin.lp_hp = NULL;
+	    pin.lp_alloc = NULL;
 	}
-
-	// Get the line to compare with.
-	p = reg_getline(clnum);
 	if (clnum == end_lnum)
 	    len = end_col - ccol;
 	else
 	    len = (int)reg_getline_len(clnum) - ccol;
+	rex.line = reg_getline(rex.lnum);
+	rex.input = rex.line + input_col;
 
 	// Use case-insensitive compare if rex.reg_ic is set
-	if ((!rex.reg_ic && cstrncmp(p + ccol, rex.input, &len) != 0)
-	    || (rex.reg_ic && MB_STRNICMP(p + ccol, rex.input, len) != 0))
+	differ = (!rex.reg_ic && cstrncmp(p + ccol, rex.input, &len) != 0)
+		|| (rex.reg_ic && MB_STRNICMP(p + ccol, rex.input, len) != 0);
+	ml_unpin_line(&pin);
+	if (differ)
 	    return RA_NOMATCH;  // doesn't match
 	if (bytelen != NULL)
 	    *bytelen += len;
@@ -1635,8 +1717,7 @@ match_with_backref(
 	    return RA_FAIL;
     }
 
-    // found a match!  Note that rex.line may now point to a copy of the line,
-    // that should not matter.
+    // found a match!
     return RA_MATCH;
 }
 
@@ -1873,6 +1954,105 @@ cstrchr(char_u *s, int c)
     return NULL;
 }
 
+/*
+ * Return TRUE if "s" starts with "must" of "mustlen" bytes, ignoring case.
+ * For UTF-8 the text may use a different number of bytes than "must".
+ */
+    static int
+reg_must_equal_ic(char_u *s, char_u *must, int mustlen)
+{
+    char_u  *p = s;
+    char_u  *q = must;
+    int	    c1, c2;
+
+    if (!enc_utf8)
+	return MB_STRNICMP(s, must, mustlen) == 0;
+    while (q < must + mustlen)
+    {
+	if (*p == NUL)
+	    return FALSE;
+	c1 = utf_ptr2char(p);
+	c2 = utf_ptr2char(q);
+	if (c1 != c2 && utf_fold(c1) != utf_fold(c2))
+	    return FALSE;
+	p += utf_ptr2len(p);
+	q += utf_ptr2len(q);
+    }
+    return TRUE;
+}
+
+/*
+ * Find literal text "must" of "mustlen" bytes in "s", taking rex.reg_ic into
+ * account.  Used to quickly skip lines that cannot match.
+ * Returns a pointer to where it was found or NULL.  When ignoring combining
+ * characters returns "s", the text may match in many ways.
+ */
+    static char_u *
+reg_find_must(char_u *s, char_u *must, int mustlen)
+{
+    int	    c;
+
+    if (rex.reg_icombine && enc_utf8)
+	return s;
+
+    // This is used very often, esp. for ":global".  Without ignoring case
+    // the C library strstr() is fastest, it usually uses SIMD instructions.
+    if (!rex.reg_ic)
+	return (char_u *)strstr((char *)s, (char *)must);
+
+    if (has_mbyte)
+	c = (*mb_ptr2char)(must);
+    else
+	c = *must;
+    while ((s = cstrchr(s, c)) != NULL)
+    {
+	if (reg_must_equal_ic(s, must, mustlen))
+	    break;		// Found it.
+	MB_PTR_ADV(s);
+    }
+    return s;
+}
+
+#if defined(FEAT_QUICKFIX) || defined(PROTO)
+/*
+ * Return the text that every match of "prog" must contain, so that text can
+ * be skipped quickly when it doesn't contain it.  "ic" is the 'ignorecase'
+ * value that will be used for matching.  "*icp" is set to TRUE when case must
+ * be ignored when looking for the text.
+ * Only plain ASCII text is returned, it is not changed by converting from
+ * another encoding.  When ignoring case only utf-8 is supported, other
+ * encodings may use the locale.  Then "k" and "s" are not used, they also
+ * match the Kelvin sign and the long s.
+ * Returns NULL when there is no such text.
+ */
+    char_u *
+vim_regprog_must_text(regprog_T *prog, int ic, int *icp)
+{
+    char_u	*must;
+    char_u	*p;
+
+    if (prog->regflags & RF_ICOMBINE)
+	return NULL;
+    if (prog->regflags & RF_ICASE)
+	ic = TRUE;
+    else if (prog->regflags & RF_NOICASE)
+	ic = FALSE;
+
+    if (prog->engine == &nfa_regengine)
+	must = ((nfa_regprog_T *)prog)->must_text;
+    else
+	must = ((bt_regprog_T *)prog)->regmust;
+    if (must == NULL || *must == NUL || (ic && !enc_utf8))
+	return NULL;
+
+    for (p = must; *p != NUL; ++p)
+	if (*p >= 0x80 || (ic && vim_strchr((char_u *)"kKsS", *p) != NULL))
+	    return NULL;
+    *icp = ic;
+    return must;
+}
+#endif
+
 ////////////////////////////////////////////////////////////////
 //		      regsub stuff			      //
 ////////////////////////////////////////////////////////////////
@@ -2090,12 +2270,7 @@ vim_regsub(
 {
     int		result;
     regexec_T	rex_save;
-    int		rex_in_use_save = rex_in_use;
-
-    if (rex_in_use)
-	// Being called recursively, save the state.
-	rex_save = rex;
-    rex_in_use = TRUE;
+    int		rex_in_use_save = rex_enter(&rex_save);
 
     rex.reg_match = rmp;
     rex.reg_mmatch = NULL;
@@ -2104,9 +2279,7 @@ vim_regsub(
     rex.reg_line_lbr = TRUE;
     result = vim_regsub_both(source, expr, dest, destlen, flags);
 
-    rex_in_use = rex_in_use_save;
-    if (rex_in_use)
-	rex = rex_save;
+    rex_leave(&rex_save, rex_in_use_save);
 
     return result;
 }
@@ -2122,12 +2295,7 @@ vim_regsub_multi(
 {
     int		result;
     regexec_T	rex_save;
-    int		rex_in_use_save = rex_in_use;
-
-    if (rex_in_use)
-	// Being called recursively, save the state.
-	rex_save = rex;
-    rex_in_use = TRUE;
+    int		rex_in_use_save = rex_enter(&rex_save);
 
     rex.reg_match = NULL;
     rex.reg_mmatch = rmp;
@@ -2137,9 +2305,7 @@ vim_regsub_multi(
     rex.reg_line_lbr = FALSE;
     result = vim_regsub_both(source, NULL, dest, destlen, flags);
 
-    rex_in_use = rex_in_use_save;
-    if (rex_in_use)
-	rex = rex_save;
+    rex_leave(&rex_save, rex_in_use_save);
 
     return result;
 }
@@ -2915,6 +3081,359 @@ static const char_u regname[][30] = {
 			    };
 #endif
 
+#if defined(FEAT_PROFILE) || defined(PROTO)
+/*
+ * Profiling of regexps, for ":regprofile" and regexpstats().  The numbers are
+ * kept per pattern, for programs compiled while profiling was on.  Entries
+ * are not freed until exiting, programs point to them.
+ */
+typedef struct regprof_S regprof_T;
+
+struct regprof_S
+{
+    long	rp_compiled;	// nr of times compiled
+    proftime_T	rp_comp_time;	// total time spent compiling
+    long	rp_size;	// size of the last compiled program
+    int		rp_engines;	// REGPROF_ flags of engines used
+    long	rp_count;	// nr of times executed
+    long	rp_match;	// nr of times matched
+    proftime_T	rp_total;	// total time spent executing
+    proftime_T	rp_slowest;	// time of slowest execution
+    long	rp_bt_steps;	// items tried by the backtracking engine
+    long	rp_nfa_states;	// states handled by the NFA engine
+    long	rp_timeouts;	// nr of times a timeout was hit
+    char_u	rp_pattern[1];	// actually longer
+};
+
+# define REGPROF_BT	1
+# define REGPROF_NFA	2
+
+# define HI2RP(hi)	((regprof_T *)((hi)->hi_key - offsetof(regprof_T, rp_pattern)))
+
+static int	    regprof_on = FALSE;
+static hashtab_T    regprof_ht;
+static int	    regprof_ht_init = FALSE;
+
+    static int
+regprof_engine(regprog_T *prog)
+{
+    return prog->engine == &bt_regengine ? REGPROF_BT : REGPROF_NFA;
+}
+
+/*
+ * Called after "prog" was compiled from "expr", "tm" was set when starting.
+ * Returns the profiling entry for "expr", NULL when out of memory.
+ */
+    static regprof_T *
+regprof_compiled(char_u *expr, regprog_T *prog, proftime_T *tm)
+{
+    hash_T	hash;
+    hashitem_T	*hi;
+    regprof_T	*rp;
+    size_t	len;
+
+    profile_end(tm);
+    if (!regprof_ht_init)
+    {
+	hash_init(&regprof_ht);
+	regprof_ht_init = TRUE;
+    }
+    hash = hash_hash(expr);
+    hi = hash_lookup(&regprof_ht, expr, hash);
+    if (HASHITEM_EMPTY(hi))
+    {
+	len = STRLEN(expr);
+	rp = alloc_clear(offsetof(regprof_T, rp_pattern) + len + 1);
+	if (rp == NULL)
+	    return NULL;
+	mch_memmove(rp->rp_pattern, expr, len + 1);
+	profile_zero(&rp->rp_comp_time);
+	profile_zero(&rp->rp_total);
+	profile_zero(&rp->rp_slowest);
+	if (hash_add_item(&regprof_ht, hi, rp->rp_pattern, hash) == FAIL)
+	{
+	    vim_free(rp);
+	    return NULL;
+	}
+    }
+    else
+	rp = HI2RP(hi);
+
+    ++rp->rp_compiled;
+    profile_add(&rp->rp_comp_time, tm);
+    if (prog->engine == &bt_regengine)
+	rp->rp_size = (long)sizeof(bt_regprog_T) + regsize;
+    else
+	rp->rp_size = (long)sizeof(nfa_regprog_T)
+	       + (((nfa_regprog_T *)prog)->nstate - 1) * (long)sizeof(nfa_state_T);
+    return rp;
+}
+
+/*
+ * Remember the counters before executing a program.
+ */
+    static void
+regprof_exec_start(proftime_T *tm, long *steps)
+{
+    steps[0] = regprof_bt_steps;
+    steps[1] = regprof_nfa_states;
+    profile_start(tm);
+}
+
+/*
+ * Add the numbers for executing a program with profiling entry "rp".
+ * "engines" are the REGPROF_ flags for the programs used.
+ */
+    static void
+regprof_exec_end(
+	regprof_T   *rp,
+	int	    engines,
+	proftime_T  *tm,
+	long	    *steps,
+	int	    matched,
+	int	    timed_out)
+{
+    profile_end(tm);
+    profile_add(&rp->rp_total, tm);
+    if (profile_cmp(tm, &rp->rp_slowest) < 0)
+	rp->rp_slowest = *tm;
+    rp->rp_engines |= engines;
+    ++rp->rp_count;
+    if (matched)
+	++rp->rp_match;
+    if (timed_out)
+	++rp->rp_timeouts;
+    rp->rp_bt_steps += regprof_bt_steps - steps[0];
+    rp->rp_nfa_states += regprof_nfa_states - steps[1];
+}
+
+/*
+ * Set all the counters to zero.  Entries are kept, programs point to them.
+ */
+    static void
+regprof_clear(void)
+{
+    hashitem_T	*hi;
+    regprof_T	*rp;
+    long	todo;
+
+    if (!regprof_ht_init)
+	return;
+    todo = (long)regprof_ht.ht_used;
+    FOR_ALL_HASHTAB_ITEMS(&regprof_ht, hi, todo)
+    {
+	if (HASHITEM_EMPTY(hi))
+	    continue;
+	--todo;
+	rp = HI2RP(hi);
+	rp->rp_compiled = 0;
+	profile_zero(&rp->rp_comp_time);
+	rp->rp_engines = 0;
+	rp->rp_count = 0;
+	rp->rp_match = 0;
+	profile_zero(&rp->rp_total);
+	profile_zero(&rp->rp_slowest);
+	rp->rp_bt_steps = 0;
+	rp->rp_nfa_states = 0;
+	rp->rp_timeouts = 0;
+    }
+}
+
+    static char *
+regprof_engine_name(int engines)
+{
+    if (engines == (REGPROF_BT | REGPROF_NFA))
+	return "both";
+    return engines == REGPROF_BT ? "bt" : engines == REGPROF_NFA ? "nfa" : "";
+}
+
+    static int
+regprof_compare(const void *v1, const void *v2)
+{
+    const regprof_T *rp1 = *(const regprof_T **)v1;
+    const regprof_T *rp2 = *(const regprof_T **)v2;
+
+    return profile_cmp(&rp1->rp_total, &rp2->rp_total);
+}
+
+/*
+ * Get the entries that have been compiled or executed since the last clear,
+ * sorted on total execution time.  Returns the number of entries, the array
+ * in "*entries" must be freed.
+ */
+    static int
+regprof_get_entries(regprof_T ***entries)
+{
+    hashitem_T	*hi;
+    regprof_T	*rp;
+    long	todo;
+    int		count = 0;
+
+    *entries = NULL;
+    if (!regprof_ht_init || regprof_ht.ht_used == 0)
+	return 0;
+    *entries = ALLOC_MULT(regprof_T *, regprof_ht.ht_used);
+    if (*entries == NULL)
+	return 0;
+    todo = (long)regprof_ht.ht_used;
+    FOR_ALL_HASHTAB_ITEMS(&regprof_ht, hi, todo)
+    {
+	if (HASHITEM_EMPTY(hi))
+	    continue;
+	--todo;
+	rp = HI2RP(hi);
+	if (rp->rp_compiled > 0 || rp->rp_count > 0)
+	    (*entries)[count++] = rp;
+    }
+    if (count > 1)
+	qsort(*entries, (size_t)count, sizeof(regprof_T *),
+							 regprof_compare);
+    return count;
+}
+
+/*
+ * ":regprofile report".
+ */
+    static void
+regprof_report(void)
+{
+    regprof_T	**entries;
+    regprof_T	*rp;
+    int		count;
+    int		idx;
+    int		len;
+
+    count = regprof_get_entries(&entries);
+    msg_puts_title(_("  TOTAL      COUNT  MATCH   SLOWEST     STEPS     TIMEOUT COMPILE      SIZE   ENGINE PATTERN"));
+    msg_puts("\n");
+    for (idx = 0; idx < count && !got_int; ++idx)
+    {
+	rp = entries[idx];
+
+	msg_puts(profile_msg(&rp->rp_total));
+	msg_puts(" "); // make sure there is always a separating space
+	msg_advance(13);
+	msg_outnum(rp->rp_count);
+	msg_puts(" ");
+	msg_advance(20);
+	msg_outnum(rp->rp_match);
+	msg_puts(" ");
+	msg_advance(26);
+	msg_puts(profile_msg(&rp->rp_slowest));
+	msg_puts(" ");
+	msg_advance(38);
+	msg_outnum(rp->rp_bt_steps + rp->rp_nfa_states);
+	msg_puts(" ");
+	msg_advance(48);
+	msg_outnum(rp->rp_timeouts);
+	msg_puts(" ");
+	msg_advance(56);
+	msg_puts(profile_msg(&rp->rp_comp_time));
+	msg_puts(" ");
+	msg_advance(69);
+	msg_outnum(rp->rp_size);
+	msg_puts(" ");
+	msg_advance(76);
+	msg_puts(regprof_engine_name(rp->rp_engines));
+	msg_puts(" ");
+	msg_advance(83);
+	if (Columns < 100)
+	    len = 20; // will wrap anyway
+	else
+	    len = Columns - 84;
+	if (len > (int)STRLEN(rp->rp_pattern))
+	    len = (int)STRLEN(rp->rp_pattern);
+	msg_outtrans_len(rp->rp_pattern, len);
+	msg_puts("\n");
+    }
+    vim_free(entries);
+}
+
+/*
+ * ":regprofile {on,off,clear,report}".
+ */
+    void
+ex_regprofile(exarg_T *eap)
+{
+    if (STRCMP(eap->arg, "on") == 0)
+	regprof_on = TRUE;
+    else if (STRCMP(eap->arg, "off") == 0)
+	regprof_on = FALSE;
+    else if (STRCMP(eap->arg, "clear") == 0)
+	regprof_clear();
+    else if (STRCMP(eap->arg, "report") == 0)
+	regprof_report();
+    else
+	semsg(_(e_invalid_argument_str), eap->arg);
+}
+
+# if defined(EXITFREE) || defined(PROTO)
+    static void
+regprof_free(void)
+{
+    hashitem_T	*hi;
+    long	todo;
+
+    if (!regprof_ht_init)
+	return;
+    todo = (long)regprof_ht.ht_used;
+    FOR_ALL_HASHTAB_ITEMS(&regprof_ht, hi, todo)
+    {
+	if (HASHITEM_EMPTY(hi))
+	    continue;
+	--todo;
+	vim_free(HI2RP(hi));
+    }
+    hash_clear(&regprof_ht);
+    regprof_ht_init = FALSE;
+}
+# endif
+#endif
+
+#if defined(FEAT_EVAL) || defined(PROTO)
+/*
+ * "regexpstats()" function
+ */
+    void
+f_regexpstats(typval_T *argvars UNUSED, typval_T *rettv)
+{
+# ifdef FEAT_PROFILE
+    regprof_T	**entries;
+    regprof_T	*rp;
+    int		count;
+    int		idx;
+    dict_T	*d;
+# endif
+
+    if (rettv_list_alloc(rettv) == FAIL)
+	return;
+# ifdef FEAT_PROFILE
+    count = regprof_get_entries(&entries);
+    for (idx = 0; idx < count; ++idx)
+    {
+	rp = entries[idx];
+	d = dict_alloc();
+	if (d == NULL || list_append_dict(rettv->vval.v_list, d) == FAIL)
+	    break;
+	dict_add_string(d, "pattern", rp->rp_pattern);
+	dict_add_string(d, "engine",
+			       (char_u *)regprof_engine_name(rp->rp_engines));
+	dict_add_number(d, "compiled", rp->rp_compiled);
+	dict_add_float(d, "compiletime", profile_float(&rp->rp_comp_time));
+	dict_add_number(d, "size", rp->rp_size);
+	dict_add_number(d, "count", rp->rp_count);
+	dict_add_number(d, "match", rp->rp_match);
+	dict_add_float(d, "total", profile_float(&rp->rp_total));
+	dict_add_float(d, "slowest", profile_float(&rp->rp_slowest));
+	dict_add_number(d, "btsteps", rp->rp_bt_steps);
+	dict_add_number(d, "nfastates", rp->rp_nfa_states);
+	dict_add_number(d, "timeouts", rp->rp_timeouts);
+    }
+    vim_free(entries);
+# endif
+}
+#endif
+
 /*
  * Compile a regular expression into internal code.
  * Returns the program in allocated memory.
@@ -2927,6 +3446,12 @@ vim_regcomp(char_u *expr_arg, int re_flags)
     regprog_T   *prog = NULL;
     char_u	*expr = expr_arg;
     int		called_emsg_before;
+#ifdef FEAT_PROFILE
+    proftime_T	comp_tm;
+
+    if (regprof_on)
+	profile_start(&comp_tm);
+#endif
 
     regexp_engine = p_re;
 
@@ -3010,6 +3535,10 @@ vim_regcomp(char_u *expr_arg, int re_flags)
 	// out to be very slow when executing it.
 	prog->re_engine = regexp_engine;
 	prog->re_flags  = re_flags;
+#ifdef FEAT_PROFILE
+	prog->re_prof = regprof_on
+			   ? regprof_compiled(expr, prog, &comp_tm) : NULL;
+#endif
     }
 
     return prog;
@@ -3025,14 +3554,165 @@ vim_regfree(regprog_T *prog)
 	prog->engine->regfree(prog);
 }
 
+/*
+ * Cache of compiled patterns used by functions such as substitute() and
+ * matchstr().  A plugin calling them in a loop with the same pattern would
+ * otherwise compile it again for every call.
+ * A program is taken out of the cache while it is being used, the entry then
+ * only remembers the key (rc_prog is NULL).  This way a recursive call with
+ * the same pattern, e.g. from a substitute() expression, compiles its own
+ * program.
+ */
+# define REGCACHE_SIZE	32
+
+typedef struct {
+    char_u	*rc_pat;	// pattern, NULL for an unused entry
+    int		rc_flags;	// "re_flags" passed to vim_regcomp()
+    int		rc_opts;	// options that affect compiling, see below
+    regprog_T	*rc_prog;	// compiled program, NULL when lent out
+    long	rc_used;	// value of regcache_tick when last used
+} regcache_T;
+
+static regcache_T   regcache[REGCACHE_SIZE];
+static long	    regcache_tick = 0;
+
+/*
+ * Return a number for the option values that are used when compiling a
+ * pattern.  'ignorecase' is not used, it is passed when executing.
+ */
+    static int
+regcache_opts(void)
+{
+    return p_re
+	| (vim_strchr(p_cpo, CPO_LITERAL) != NULL ? 0x04 : 0)
+	| (vim_strchr(p_cpo, CPO_BACKSL) != NULL ? 0x08 : 0)
+	| (enc_utf8 ? 0x10 : 0)
+	| (has_mbyte ? 0x20 : 0)
+	| (enc_dbcs << 8);
+}
+
+/*
+ * Return TRUE when the compiled form of "expr" depends on more than the
+ * pattern, flags and options: "~" uses the previous substitute string,
+ * [:keyword:] and friends use the options of the current buffer and \z()
+ * depends on the syntax item being defined.
+ */
+    static int
+regcache_allowed(char_u *expr)
+{
+#ifdef FEAT_SYN_HL
+    if (reg_do_extmatch != 0)
+	return FALSE;
+#endif
+    return vim_strchr(expr, '~') == NULL
+	&& strstr((char *)expr, "[:") == NULL;
+}
+
+/*
+ * Like vim_regcomp(), but first look for the pattern in the cache.
+ * The program must be freed with vim_regfree_cached(), using the same "expr"
+ * and "re_flags".
+ */
+    regprog_T *
+vim_regcomp_cached(char_u *expr, int re_flags)
+{
+    int		opts;
+    int		i;
+    regcache_T	*rc;
+    regcache_T	*lru = NULL;
+    regprog_T	*prog;
+    int		called_emsg_before = called_emsg;
+
+    if (!regcache_allowed(expr))
+	return vim_regcomp(expr, re_flags);
+
+    opts = regcache_opts();
+    for (i = 0; i < REGCACHE_SIZE; ++i)
+    {
+	rc = &regcache[i];
+	if (rc->rc_prog != NULL && rc->rc_flags == re_flags
+		&& rc->rc_opts == opts && STRCMP(rc->rc_pat, expr) == 0)
+	{
+	    prog = rc->rc_prog;
+	    rc->rc_prog = NULL;
+	    rc->rc_used = ++regcache_tick;
+	    return prog;
+	}
+	// Find the least recently used entry that is not lent out.
+	if ((rc->rc_pat == NULL || rc->rc_prog != NULL)
+		&& (lru == NULL || rc->rc_pat == NULL
+		    || (lru->rc_pat != NULL && rc->rc_used < lru->rc_used)))
+	    lru = rc;
+    }
+
+    prog = vim_regcomp(expr, re_flags);
+    // Don't remember a pattern that gave an error message, the message
+    // should be given again next time.
+    if (prog == NULL || lru == NULL || called_emsg != called_emsg_before)
+	return prog;
+
+    vim_free(lru->rc_pat);
+    vim_regfree(lru->rc_prog);
+    lru->rc_prog = NULL;
+    lru->rc_pat = vim_strsave(expr);
+    lru->rc_flags = re_flags;
+    lru->rc_opts = opts;
+    lru->rc_used = ++regcache_tick;
+    return prog;
+}
+
+/*
+ * Give back a program obtained with vim_regcomp_cached().  It is kept in the
+ * cache if its entry is still waiting for it, otherwise it is freed.
+ * "prog" may have been replaced by vim_regexec(), when switching engines.
+ */
+    void
+vim_regfree_cached(regprog_T *prog, char_u *expr, int re_flags)
+{
+    int		i;
+    regcache_T	*rc;
+
+    if (prog == NULL)
+	return;
+    for (i = 0; i < REGCACHE_SIZE; ++i)
+    {
+	rc = &regcache[i];
+	if (rc->rc_pat != NULL && rc->rc_prog == NULL
+		&& rc->rc_flags == re_flags && STRCMP(rc->rc_pat, expr) == 0)
+	{
+	    // The options may have changed while the program was lent out,
+	    // e.g. by an expression in substitute().
+	    if (rc->rc_opts != regcache_opts())
+	    {
+		VIM_CLEAR(rc->rc_pat);
+		break;
+	    }
+	    rc->rc_prog = prog;
+	    return;
+	}
+    }
+    vim_regfree(prog);
+}
+
 #if defined(EXITFREE)
     void
 free_regexp_stuff(void)
 {
-    ga_clear(&regstack);
-    ga_clear(&backpos);
-    vim_free(reg_tofree);
+    ga_clear(&rex.regstack);
+    ga_clear(&rex.backpos);
     vim_free(reg_prev_sub);
+# ifdef FEAT_PROFILE
+    regprof_free();
+# endif
+    {
+	int	i;
+
+	for (i = 0; i < REGCACHE_SIZE; ++i)
+	{
+	    vim_free(regcache[i].rc_pat);
+	    vim_regfree(regcache[i].rc_prog);
+	}
+    }
 }
 #endif
 
@@ -3079,7 +3759,13 @@ vim_regexec_string(
 {
     int		result;
     regexec_T	rex_save;
-    int		rex_in_use_save = rex_in_use;
+    int		rex_in_use_save;
+#ifdef FEAT_PROFILE
+    regprof_T	*rp = rmp->regprog->re_prof;
+    int		rp_engines = 0;
+    proftime_T	rp_tm;
+    long	rp_steps[2];
+#endif
 
     // Cannot use the same prog recursively, it contains state.
     if (rmp->regprog->re_in_use)
@@ -3088,11 +3774,15 @@ vim_regexec_string(
 	return FALSE;
     }
     rmp->regprog->re_in_use = TRUE;
+#ifdef FEAT_PROFILE
+    if (rp != NULL)
+    {
+	rp_engines = regprof_engine(rmp->regprog);
+	regprof_exec_start(&rp_tm, rp_steps);
+    }
+#endif
 
-    if (rex_in_use)
-	// Being called recursively, save the state.
-	rex_save = rex;
-    rex_in_use = TRUE;
+    rex_in_use_save = rex_enter(&rex_save);
 
     rex.reg_startp = NULL;
     rex.reg_endp = NULL;
@@ -3130,10 +3820,16 @@ vim_regexec_string(
 	p_re = save_p_re;
     }
 
-    rex_in_use = rex_in_use_save;
-    if (rex_in_use)
-	rex = rex_save;
+    rex_leave(&rex_save, rex_in_use_save);
 
+#ifdef FEAT_PROFILE
+    if (rp != NULL)
+    {
+	if (rmp->regprog != NULL)
+	    rp_engines |= regprof_engine(rmp->regprog);
+	regprof_exec_end(rp, rp_engines, &rp_tm, rp_steps, result > 0, FALSE);
+    }
+#endif
     return result > 0;
 }
 
@@ -3201,7 +3897,14 @@ vim_regexec_multi(
 {
     int		result;
     regexec_T	rex_save;
-    int		rex_in_use_save = rex_in_use;
+    int		rex_in_use_save;
+#ifdef FEAT_PROFILE
+    regprof_T	*rp = rmp->regprog->re_prof;
+    int		rp_engines = 0;
+    proftime_T	rp_tm;
+    long	rp_steps[2];
+    int		rp_timed_out = timed_out != NULL && *timed_out;
+#endif
 
     // Cannot use the same prog recursively, it contains state.
     if (rmp->regprog->re_in_use)
@@ -3210,11 +3913,15 @@ vim_regexec_multi(
 	return FALSE;
     }
     rmp->regprog->re_in_use = TRUE;
+#ifdef FEAT_PROFILE
+    if (rp != NULL)
+    {
+	rp_engines = regprof_engine(rmp->regprog);
+	regprof_exec_start(&rp_tm, rp_steps);
+    }
+#endif
 
-    if (rex_in_use)
-	// Being called recursively, save the state.
-	rex_save = rex;
-    rex_in_use = TRUE;
+    rex_in_use_save = rex_enter(&rex_save);
 
     result = rmp->regprog->engine->regexec_multi(
 				      rmp, win, buf, lnum, col, timed_out);
@@ -3265,9 +3972,13 @@ vim_regexec_multi(
 	p_re = save_p_re;
     }
 
-    rex_in_use = rex_in_use_save;
-    if (rex_in_use)
-	rex = rex_save;
+    rex_leave(&rex_save, rex_in_use_save);
 
+#ifdef FEAT_PROFILE
+    if (rp != NULL)
+	regprof_exec_end(rp, rp_engines | regprof_engine(rmp->regprog),
+		&rp_tm, rp_steps, result > 0,
+		!rp_timed_out && timed_out != NULL && *timed_out);
+#endif
     return result <= 0 ? 0 : result;
 }
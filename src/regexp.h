@@ -53,6 +53,9 @@ typedef struct regprog
     unsigned		re_engine;   // automatic, backtracking or nfa engine
     unsigned		re_flags;    // second argument for vim_regcomp()
     int			re_in_use;   // prog is being executed
+#ifdef FEAT_PROFILE
+    struct regprof_S	*re_prof;    // for ":regprofile", can be NULL
+#endif
 } regprog_T;
 
 /*
@@ -68,6 +71,9 @@ typedef struct
     unsigned		re_engine;
     unsigned		re_flags;
     int			re_in_use;
+#ifdef FEAT_PROFILE
+    struct regprof_S	*re_prof;
+#endif
 
     int			regstart;
     char_u		reganch;
@@ -97,6 +103,9 @@ struct nfa_state
     int			val;
 };
 
+// Lazily built DFA, defined in regexp_nfa.c.
+typedef struct nfa_dfa_S nfa_dfa_T;
+
 /*
  * Structure used by the NFA matcher.
  */
@@ -108,18 +117,24 @@ typedef struct
     unsigned		re_engine;
     unsigned		re_flags;
     int			re_in_use;
+#ifdef FEAT_PROFILE
+    struct regprof_S	*re_prof;
+#endif
 
     nfa_state_T		*start;		// points into state[]
 
     int			reganch;	// pattern starts with ^
     int			regstart;	// char at start of pattern
     char_u		*match_text;	// plain text to match with
+    char_u		*must_text;	// text that every match contains
 
     int			has_zend;	// pattern contains \ze
     int			has_backref;	// pattern contains \1 .. \9
 #ifdef FEAT_SYN_HL
     int			reghasz;
 #endif
+    int			dfa_ok;		// DFA can be used to check for a match
+    nfa_dfa_T		*dfa;		// DFA built so far or NULL
     char_u		*pattern;
     int			nsubexp;	// number of ()
     int			nstate;
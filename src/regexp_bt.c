@@ -54,12 +54,12 @@
  *
  * Regstart and reganch permit very fast decisions on suitable starting points
  * for a match, cutting down the work a lot.  Regmust permits fast rejection
- * of lines that cannot possibly match.  The regmust tests are costly enough
- * that vim_regcomp() supplies a regmust only if the r.e. contains something
- * potentially expensive (at present, the only such thing detected is * or +
- * at the start of the r.e., which can involve a lot of backup).  Regmlen is
- * supplied because the test in vim_regexec() needs it and vim_regcomp() is
- * computing it anyway.
+ * of lines that cannot possibly match.  Looking for the regmust is cheap,
+ * but a single character is already handled by regstart, thus vim_regcomp()
+ * supplies a regmust only if it is longer than that or the r.e. contains
+ * something potentially expensive (* or + at the start of the r.e., which
+ * can involve a lot of backup).  Regmlen is supplied because the test in
+ * vim_regexec() needs it and vim_regcomp() is computing it anyway.
  */
 
 /*
@@ -290,31 +290,6 @@ typedef enum regstate_E
     , RS_STAR_SHORT	// STAR/PLUS/BRACE_SIMPLE shortest match
 } regstate_T;
 
-/*
- * Structure used to save the current input state, when it needs to be
- * restored after trying a match.  Used by reg_save() and reg_restore().
- * Also stores the length of "backpos".
- */
-typedef struct
-{
-    union
-    {
-	char_u	*ptr;	// rex.input pointer, for single-line regexp
-	lpos_T	pos;	// rex.input pos, for multi-line regexp
-    } rs_u;
-    int		rs_len;
-} regsave_T;
-
-// struct to save start/end pointer/position in for \(\)
-typedef struct
-{
-    union
-    {
-	char_u	*ptr;
-	lpos_T	pos;
-    } se_u;
-} save_se_T;
-
 // used for BEHIND and NOBEHIND matching
 typedef struct regbehind_S
 {
@@ -363,20 +338,8 @@ typedef struct backpos_S
 } backpos_T;
 
 /*
- * "regstack" and "backpos" are used by regmatch().  They are kept over calls
- * to avoid invoking malloc() and free() often.
- * "regstack" is a stack with regitem_T items, sometimes preceded by regstar_T
- * or regbehind_T.
- * "backpos_T" is a table with backpos_T for BACK
- */
-static garray_T	regstack = {0, 0, 0, 0, NULL};
-static garray_T	backpos = {0, 0, 0, 0, NULL};
-
-static regsave_T behind_pos;
-
-/*
- * Both for regstack and backpos tables we use the following strategy of
- * allocation (to reduce malloc/free calls):
+ * Both for the rex.regstack and rex.backpos tables we use the following
+ * strategy of allocation (to reduce malloc/free calls):
  * - Initial size is fairly small.
  * - When needed, the tables are grown bigger (8 times at first, double after
  *   that).
@@ -2559,18 +2522,18 @@ bt_regcomp(char_u *expr, int re_flags)
 		r->regstart = *OPERAND(regnext(scan));
 	}
 
-	// If there's something expensive in the r.e., find the longest
-	// literal string that must appear and make it the regmust.  Resolve
-	// ties in favor of later strings, since the regstart check works
-	// with the beginning of the r.e. and avoiding duplication
-	// strengthens checking.  Not a strong reason, but sufficient in the
-	// absence of others.
+	// Find the longest literal string that must appear and make it the
+	// regmust.  Resolve ties in favor of later strings, since the
+	// regstart check works with the beginning of the r.e. and avoiding
+	// duplication strengthens checking.  Not a strong reason, but
+	// sufficient in the absence of others.
 
 	// When the r.e. starts with BOW, it is faster to look for a regmust
 	// first. Used a lot for "#" and "*" commands. (Added by mool).
-	if ((flags & SPSTART || OP(scan) == BOW || OP(scan) == EOW)
-							  && !(flags & HASNL))
+	if (!(flags & HASNL))
 	{
+	    int	    expensive = (flags & SPSTART || OP(scan) == BOW
+							 || OP(scan) == EOW);
 	    size_t  scanlen;
 
 	    longest = NULL;
@@ -2587,8 +2550,12 @@ bt_regcomp(char_u *expr, int re_flags)
 		    }
 		}
 	    }
-	    r->regmust = longest;
-	    r->regmlen = len;
+	    if (longest != NULL && (expensive
+			 || len > (has_mbyte ? (*mb_ptr2len)(longest) : 1)))
+	    {
+		r->regmust = longest;
+		r->regmlen = len;
+	    }
 	}
     }
 #ifdef BT_REGEXP_DUMP
@@ -3141,19 +3108,19 @@ regstack_push(regstate_T state, char_u *scan)
 {
     regitem_T	*rp;
 
-    if ((long)((unsigned)regstack.ga_len >> 10) >= p_mmp)
+    if ((long)((unsigned)rex.regstack.ga_len >> 10) >= p_mmp)
     {
 	emsg(_(e_pattern_uses_more_memory_than_maxmempattern));
 	return NULL;
     }
-    if (ga_grow(&regstack, sizeof(regitem_T)) == FAIL)
+    if (ga_grow(&rex.regstack, sizeof(regitem_T)) == FAIL)
 	return NULL;
 
-    rp = (regitem_T *)((char *)regstack.ga_data + regstack.ga_len);
+    rp = (regitem_T *)((char *)rex.regstack.ga_data + rex.regstack.ga_len);
     rp->rs_state = state;
     rp->rs_scan = scan;
 
-    regstack.ga_len += sizeof(regitem_T);
+    rex.regstack.ga_len += sizeof(regitem_T);
     return rp;
 }
 
@@ -3165,10 +3132,10 @@ regstack_pop(char_u **scan)
 {
     regitem_T	*rp;
 
-    rp = (regitem_T *)((char *)regstack.ga_data + regstack.ga_len) - 1;
+    rp = (regitem_T *)((char *)rex.regstack.ga_data + rex.regstack.ga_len) - 1;
     *scan = rp->rs_scan;
 
-    regstack.ga_len -= sizeof(regitem_T);
+    rex.regstack.ga_len -= sizeof(regitem_T);
 }
 
 #ifdef FEAT_RELTIME
@@ -3281,8 +3248,8 @@ regmatch(
 
   // Make "regstack" and "backpos" empty.  They are allocated and freed in
   // bt_regexec_both() to reduce malloc()/free() calls.
-  regstack.ga_len = 0;
-  backpos.ga_len = 0;
+  rex.regstack.ga_len = 0;
+  rex.backpos.ga_len = 0;
 
   // Repeat until "regstack" is empty.
   for (;;)
@@ -3316,6 +3283,9 @@ regmatch(
 	}
 #endif
 	status = RA_CONT;
+#ifdef FEAT_PROFILE
+	++regprof_bt_steps;
+#endif
 
 #ifdef DEBUG
 	if (regnarrate)
@@ -3875,21 +3845,21 @@ regmatch(
 		// at the same position as the previous time.
 		// The positions are stored in "backpos" and found by the
 		// current value of "scan", the position in the RE program.
-		bp = (backpos_T *)backpos.ga_data;
-		for (i = 0; i < backpos.ga_len; ++i)
+		bp = (backpos_T *)rex.backpos.ga_data;
+		for (i = 0; i < rex.backpos.ga_len; ++i)
 		    if (bp[i].bp_scan == scan)
 			break;
-		if (i == backpos.ga_len)
+		if (i == rex.backpos.ga_len)
 		{
 		    // First time at this BACK, make room to store the pos.
-		    if (ga_grow(&backpos, 1) == FAIL)
+		    if (ga_grow(&rex.backpos, 1) == FAIL)
 			status = RA_FAIL;
 		    else
 		    {
 			// get "ga_data" again, it may have changed
-			bp = (backpos_T *)backpos.ga_data;
+			bp = (backpos_T *)rex.backpos.ga_data;
 			bp[i].bp_scan = scan;
-			++backpos.ga_len;
+			++rex.backpos.ga_len;
 		    }
 		}
 		else if (reg_save_equal(&bp[i].bp_pos))
@@ -3897,7 +3867,7 @@ regmatch(
 		    status = RA_NOMATCH;
 
 		if (status != RA_FAIL && status != RA_NOMATCH)
-		    reg_save(&bp[i].bp_pos, &backpos);
+		    reg_save(&bp[i].bp_pos, &rex.backpos);
 	    }
 	    break;
 
@@ -3953,8 +3923,8 @@ regmatch(
 		else
 		{
 		    rp->rs_no = no;
-		    save_se(&rp->rs_un.sesave, &reg_startzpos[no],
-							     &reg_startzp[no]);
+		    save_se(&rp->rs_un.sesave, &rex.reg_startzpos[no],
+							 &rex.reg_startzp[no]);
 		    // We simply continue and handle the result when done.
 		}
 	    }
@@ -4006,8 +3976,8 @@ regmatch(
 		else
 		{
 		    rp->rs_no = no;
-		    save_se(&rp->rs_un.sesave, &reg_endzpos[no],
-							      &reg_endzp[no]);
+		    save_se(&rp->rs_un.sesave, &rex.reg_endzpos[no],
+							   &rex.reg_endzp[no]);
 		    // We simply continue and handle the result when done.
 		}
 	    }
@@ -4181,7 +4151,7 @@ regmatch(
 		    else
 		    {
 			rp->rs_no = no;
-			reg_save(&rp->rs_un.regsave, &backpos);
+			reg_save(&rp->rs_un.regsave, &rex.backpos);
 			next = OPERAND(scan);
 			// We continue and handle the result when done.
 		    }
@@ -4200,7 +4170,7 @@ regmatch(
 			else
 			{
 			    rp->rs_no = no;
-			    reg_save(&rp->rs_un.regsave, &backpos);
+			    reg_save(&rp->rs_un.regsave, &rex.backpos);
 			    next = OPERAND(scan);
 			    // We continue and handle the result when done.
 			}
@@ -4216,7 +4186,7 @@ regmatch(
 			    status = RA_FAIL;
 			else
 			{
-			    reg_save(&rp->rs_un.regsave, &backpos);
+			    reg_save(&rp->rs_un.regsave, &rex.backpos);
 			    // We continue and handle the result when done.
 			}
 		    }
@@ -4277,16 +4247,16 @@ regmatch(
 		    // It could match.  Prepare for trying to match what
 		    // follows.  The code is below.  Parameters are stored in
 		    // a regstar_T on the regstack.
-		    if ((long)((unsigned)regstack.ga_len >> 10) >= p_mmp)
+		    if ((long)((unsigned)rex.regstack.ga_len >> 10) >= p_mmp)
 		    {
 			emsg(_(e_pattern_uses_more_memory_than_maxmempattern));
 			status = RA_FAIL;
 		    }
-		    else if (ga_grow(&regstack, sizeof(regstar_T)) == FAIL)
+		    else if (ga_grow(&rex.regstack, sizeof(regstar_T)) == FAIL)
 			status = RA_FAIL;
 		    else
 		    {
-			regstack.ga_len += sizeof(regstar_T);
+			rex.regstack.ga_len += sizeof(regstar_T);
 			rp = regstack_push(rst.minval <= rst.maxval
 					? RS_STAR_LONG : RS_STAR_SHORT, scan);
 			if (rp == NULL)
@@ -4313,7 +4283,7 @@ regmatch(
 	    else
 	    {
 		rp->rs_no = op;
-		reg_save(&rp->rs_un.regsave, &backpos);
+		reg_save(&rp->rs_un.regsave, &rex.backpos);
 		next = OPERAND(scan);
 		// We continue and handle the result when done.
 	    }
@@ -4322,16 +4292,16 @@ regmatch(
 	  case BEHIND:
 	  case NOBEHIND:
 	    // Need a bit of room to store extra positions.
-	    if ((long)((unsigned)regstack.ga_len >> 10) >= p_mmp)
+	    if ((long)((unsigned)rex.regstack.ga_len >> 10) >= p_mmp)
 	    {
 		emsg(_(e_pattern_uses_more_memory_than_maxmempattern));
 		status = RA_FAIL;
 	    }
-	    else if (ga_grow(&regstack, sizeof(regbehind_T)) == FAIL)
+	    else if (ga_grow(&rex.regstack, sizeof(regbehind_T)) == FAIL)
 		status = RA_FAIL;
 	    else
 	    {
-		regstack.ga_len += sizeof(regbehind_T);
+		rex.regstack.ga_len += sizeof(regbehind_T);
 		rp = regstack_push(RS_BEHIND1, scan);
 		if (rp == NULL)
 		    status = RA_FAIL;
@@ -4342,7 +4312,7 @@ regmatch(
 		    save_subexpr(((regbehind_T *)rp) - 1);
 
 		    rp->rs_no = op;
-		    reg_save(&rp->rs_un.regsave, &backpos);
+		    reg_save(&rp->rs_un.regsave, &rex.backpos);
 		    // First try if what follows matches.  If it does then we
 		    // check the behind match by looping.
 		}
@@ -4352,11 +4322,12 @@ regmatch(
 	  case BHPOS:
 	    if (REG_MULTI)
 	    {
-		if (behind_pos.rs_u.pos.col != (colnr_T)(rex.input - rex.line)
-			|| behind_pos.rs_u.pos.lnum != rex.lnum)
+		if (rex.behind_pos.rs_u.pos.col
+					     != (colnr_T)(rex.input - rex.line)
+			|| rex.behind_pos.rs_u.pos.lnum != rex.lnum)
 		    status = RA_NOMATCH;
 	    }
-	    else if (behind_pos.rs_u.ptr != rex.input)
+	    else if (rex.behind_pos.rs_u.ptr != rex.input)
 		status = RA_NOMATCH;
 	    break;
 
@@ -4396,9 +4367,10 @@ regmatch(
 
     // If there is something on the regstack execute the code for the state.
     // If the state is popped then loop and use the older state.
-    while (regstack.ga_len > 0 && status != RA_FAIL)
+    while (rex.regstack.ga_len > 0 && status != RA_FAIL)
     {
-	rp = (regitem_T *)((char *)regstack.ga_data + regstack.ga_len) - 1;
+	rp = (regitem_T *)((char *)rex.regstack.ga_data
+						    + rex.regstack.ga_len) - 1;
 	switch (rp->rs_state)
 	{
 	  case RS_NOPEN:
@@ -4418,8 +4390,8 @@ regmatch(
 	  case RS_ZOPEN:
 	    // Pop the state.  Restore pointers when there is no match.
 	    if (status == RA_NOMATCH)
-		restore_se(&rp->rs_un.sesave, &reg_startzpos[rp->rs_no],
-						 &reg_startzp[rp->rs_no]);
+		restore_se(&rp->rs_un.sesave, &rex.reg_startzpos[rp->rs_no],
+						 &rex.reg_startzp[rp->rs_no]);
 	    regstack_pop(&scan);
 	    break;
 #endif
@@ -4436,8 +4408,8 @@ regmatch(
 	  case RS_ZCLOSE:
 	    // Pop the state.  Restore pointers when there is no match.
 	    if (status == RA_NOMATCH)
-		restore_se(&rp->rs_un.sesave, &reg_endzpos[rp->rs_no],
-						   &reg_endzp[rp->rs_no]);
+		restore_se(&rp->rs_un.sesave, &rex.reg_endzpos[rp->rs_no],
+						   &rex.reg_endzp[rp->rs_no]);
 	    regstack_pop(&scan);
 	    break;
 #endif
@@ -4451,7 +4423,7 @@ regmatch(
 		if (status != RA_BREAK)
 		{
 		    // After a non-matching branch: try next one.
-		    reg_restore(&rp->rs_un.regsave, &backpos);
+		    reg_restore(&rp->rs_un.regsave, &rex.backpos);
 		    scan = rp->rs_scan;
 		}
 		if (scan == NULL || OP(scan) != BRANCH)
@@ -4464,7 +4436,7 @@ regmatch(
 		{
 		    // Prepare to try a branch.
 		    rp->rs_scan = regnext(scan);
-		    reg_save(&rp->rs_un.regsave, &backpos);
+		    reg_save(&rp->rs_un.regsave, &rex.backpos);
 		    scan = OPERAND(scan);
 		}
 	    }
@@ -4474,7 +4446,7 @@ regmatch(
 	    // Pop the state.  Restore pointers when there is no match.
 	    if (status == RA_NOMATCH)
 	    {
-		reg_restore(&rp->rs_un.regsave, &backpos);
+		reg_restore(&rp->rs_un.regsave, &rex.backpos);
 		--brace_count[rp->rs_no];	// decrement match count
 	    }
 	    regstack_pop(&scan);
@@ -4485,7 +4457,7 @@ regmatch(
 	    if (status == RA_NOMATCH)
 	    {
 		// There was no match, but we did find enough matches.
-		reg_restore(&rp->rs_un.regsave, &backpos);
+		reg_restore(&rp->rs_un.regsave, &rex.backpos);
 		--brace_count[rp->rs_no];
 		// continue with the items after "\{}"
 		status = RA_CONT;
@@ -4499,7 +4471,7 @@ regmatch(
 	    // Pop the state.  Restore pointers when there is no match.
 	    if (status == RA_NOMATCH)
 		// There was no match, try to match one more item.
-		reg_restore(&rp->rs_un.regsave, &backpos);
+		reg_restore(&rp->rs_un.regsave, &rex.backpos);
 	    regstack_pop(&scan);
 	    if (status == RA_NOMATCH)
 	    {
@@ -4518,7 +4490,7 @@ regmatch(
 	    {
 		status = RA_CONT;
 		if (rp->rs_no != SUBPAT)	// zero-width
-		    reg_restore(&rp->rs_un.regsave, &backpos);
+		    reg_restore(&rp->rs_un.regsave, &rex.backpos);
 	    }
 	    regstack_pop(&scan);
 	    if (status == RA_CONT)
@@ -4529,7 +4501,7 @@ regmatch(
 	    if (status == RA_NOMATCH)
 	    {
 		regstack_pop(&scan);
-		regstack.ga_len -= sizeof(regbehind_T);
+		rex.regstack.ga_len -= sizeof(regbehind_T);
 	    }
 	    else
 	    {
@@ -4540,7 +4512,7 @@ regmatch(
 		// the current position.
 
 		// save the position after the found match for next
-		reg_save(&(((regbehind_T *)rp) - 1)->save_after, &backpos);
+		reg_save(&(((regbehind_T *)rp) - 1)->save_after, &rex.backpos);
 
 		// Start looking for a match with operand at the current
 		// position.  Go back one character until we find the
@@ -4548,25 +4520,25 @@ regmatch(
 		// line (for multi-line matching).
 		// Set behind_pos to where the match should end, BHPOS
 		// will match it.  Save the current value.
-		(((regbehind_T *)rp) - 1)->save_behind = behind_pos;
-		behind_pos = rp->rs_un.regsave;
+		(((regbehind_T *)rp) - 1)->save_behind = rex.behind_pos;
+		rex.behind_pos = rp->rs_un.regsave;
 
 		rp->rs_state = RS_BEHIND2;
 
-		reg_restore(&rp->rs_un.regsave, &backpos);
+		reg_restore(&rp->rs_un.regsave, &rex.backpos);
 		scan = OPERAND(rp->rs_scan) + 4;
 	    }
 	    break;
 
 	  case RS_BEHIND2:
 	    // Looping for BEHIND / NOBEHIND match.
-	    if (status == RA_MATCH && reg_save_equal(&behind_pos))
+	    if (status == RA_MATCH && reg_save_equal(&rex.behind_pos))
 	    {
 		// found a match that ends where "next" started
-		behind_pos = (((regbehind_T *)rp) - 1)->save_behind;
+		rex.behind_pos = (((regbehind_T *)rp) - 1)->save_behind;
 		if (rp->rs_no == BEHIND)
 		    reg_restore(&(((regbehind_T *)rp) - 1)->save_after,
-								    &backpos);
+								&rex.backpos);
 		else
 		{
 		    // But we didn't want a match.  Need to restore the
@@ -4576,7 +4548,7 @@ regmatch(
 		    restore_subexpr(((regbehind_T *)rp) - 1);
 		}
 		regstack_pop(&scan);
-		regstack.ga_len -= sizeof(regbehind_T);
+		rex.regstack.ga_len -= sizeof(regbehind_T);
 	    }
 	    else
 	    {
@@ -4590,22 +4562,22 @@ regmatch(
 		{
 		    if (limit > 0
 			    && ((rp->rs_un.regsave.rs_u.pos.lnum
-						    < behind_pos.rs_u.pos.lnum
+						< rex.behind_pos.rs_u.pos.lnum
 				    ? (colnr_T)STRLEN(rex.line)
-				    : behind_pos.rs_u.pos.col)
+				    : rex.behind_pos.rs_u.pos.col)
 				- rp->rs_un.regsave.rs_u.pos.col >= limit))
 			no = FAIL;
 		    else if (rp->rs_un.regsave.rs_u.pos.col == 0)
 		    {
 			if (rp->rs_un.regsave.rs_u.pos.lnum
-					< behind_pos.rs_u.pos.lnum
+					< rex.behind_pos.rs_u.pos.lnum
 				|| reg_getline(
 					--rp->rs_un.regsave.rs_u.pos.lnum)
 								  == NULL)
 			    no = FAIL;
 			else
 			{
-			    reg_restore(&rp->rs_un.regsave, &backpos);
+			    reg_restore(&rp->rs_un.regsave, &rex.backpos);
 			    rp->rs_un.regsave.rs_u.pos.col =
 						 (colnr_T)STRLEN(rex.line);
 			}
@@ -4632,7 +4604,7 @@ regmatch(
 		    else
 		    {
 			MB_PTR_BACK(rex.line, rp->rs_un.regsave.rs_u.ptr);
-			if (limit > 0 && (long)(behind_pos.rs_u.ptr
+			if (limit > 0 && (long)(rex.behind_pos.rs_u.ptr
 				     - rp->rs_un.regsave.rs_u.ptr) > limit)
 			    no = FAIL;
 		    }
@@ -4640,7 +4612,7 @@ regmatch(
 		if (no == OK)
 		{
 		    // Advanced, prepare for finding match again.
-		    reg_restore(&rp->rs_un.regsave, &backpos);
+		    reg_restore(&rp->rs_un.regsave, &rex.backpos);
 		    scan = OPERAND(rp->rs_scan) + 4;
 		    if (status == RA_MATCH)
 		    {
@@ -4653,11 +4625,11 @@ regmatch(
 		else
 		{
 		    // Can't advance.  For NOBEHIND that's a match.
-		    behind_pos = (((regbehind_T *)rp) - 1)->save_behind;
+		    rex.behind_pos = (((regbehind_T *)rp) - 1)->save_behind;
 		    if (rp->rs_no == NOBEHIND)
 		    {
 			reg_restore(&(((regbehind_T *)rp) - 1)->save_after,
-								    &backpos);
+								&rex.backpos);
 			status = RA_MATCH;
 		    }
 		    else
@@ -4672,7 +4644,7 @@ regmatch(
 			}
 		    }
 		    regstack_pop(&scan);
-		    regstack.ga_len -= sizeof(regbehind_T);
+		    rex.regstack.ga_len -= sizeof(regbehind_T);
 		}
 	    }
 	    break;
@@ -4685,13 +4657,13 @@ regmatch(
 		if (status == RA_MATCH)
 		{
 		    regstack_pop(&scan);
-		    regstack.ga_len -= sizeof(regstar_T);
+		    rex.regstack.ga_len -= sizeof(regstar_T);
 		    break;
 		}
 
 		// Tried once already, restore input pointers.
 		if (status != RA_BREAK)
-		    reg_restore(&rp->rs_un.regsave, &backpos);
+		    reg_restore(&rp->rs_un.regsave, &rex.backpos);
 
 		// Repeat until we found a position where it could match.
 		for (;;)
@@ -4746,7 +4718,7 @@ regmatch(
 		    if (rst->nextb == NUL || *rex.input == rst->nextb
 					     || *rex.input == rst->nextb_ic)
 		    {
-			reg_save(&rp->rs_un.regsave, &backpos);
+			reg_save(&rp->rs_un.regsave, &rex.backpos);
 			scan = regnext(rp->rs_scan);
 			status = RA_CONT;
 			break;
@@ -4756,7 +4728,7 @@ regmatch(
 		{
 		    // Failed.
 		    regstack_pop(&scan);
-		    regstack.ga_len -= sizeof(regstar_T);
+		    rex.regstack.ga_len -= sizeof(regstar_T);
 		    status = RA_NOMATCH;
 		}
 	    }
@@ -4766,7 +4738,7 @@ regmatch(
 	// If we want to continue the inner loop or didn't pop a state
 	// continue matching loop
 	if (status == RA_CONT || rp == (regitem_T *)
-			     ((char *)regstack.ga_data + regstack.ga_len) - 1)
+		      ((char *)rex.regstack.ga_data + rex.regstack.ga_len) - 1)
 	    break;
 
 #ifdef FEAT_RELTIME
@@ -4783,7 +4755,7 @@ regmatch(
 	continue;
 
     // If the regstack is empty or something failed we are done.
-    if (regstack.ga_len == 0 || status == RA_FAIL)
+    if (rex.regstack.ga_len == 0 || status == RA_FAIL)
     {
 	if (scan == NULL)
 	{
@@ -4864,20 +4836,20 @@ regtry(
 	    if (REG_MULTI)
 	    {
 		// Only accept single line matches.
-		if (reg_startzpos[i].lnum >= 0
-			&& reg_endzpos[i].lnum == reg_startzpos[i].lnum
-			&& reg_endzpos[i].col >= reg_startzpos[i].col)
+		if (rex.reg_startzpos[i].lnum >= 0
+			&& rex.reg_endzpos[i].lnum == rex.reg_startzpos[i].lnum
+			&& rex.reg_endzpos[i].col >= rex.reg_startzpos[i].col)
 		    re_extmatch_out->matches[i] =
-			vim_strnsave(reg_getline(reg_startzpos[i].lnum)
-						       + reg_startzpos[i].col,
-				   reg_endzpos[i].col - reg_startzpos[i].col);
+			vim_strnsave(reg_getline(rex.reg_startzpos[i].lnum)
+						   + rex.reg_startzpos[i].col,
+			    rex.reg_endzpos[i].col - rex.reg_startzpos[i].col);
 	    }
 	    else
 	    {
-		if (reg_startzp[i] != NULL && reg_endzp[i] != NULL)
+		if (rex.reg_startzp[i] != NULL && rex.reg_endzp[i] != NULL)
 		    re_extmatch_out->matches[i] =
-			    vim_strnsave(reg_startzp[i],
-						reg_endzp[i] - reg_startzp[i]);
+			    vim_strnsave(rex.reg_startzp[i],
+				       rex.reg_endzp[i] - rex.reg_startzp[i]);
 	    }
 	}
     }
@@ -4905,20 +4877,20 @@ bt_regexec_both(
     // We allocate *_INITIAL amount of bytes first and then set the grow size
     // to much bigger value to avoid many malloc calls in case of deep regular
     // expressions.
-    if (regstack.ga_data == NULL)
+    if (rex.regstack.ga_data == NULL)
     {
 	// Use an item size of 1 byte, since we push different things
 	// onto the regstack.
-	ga_init2(&regstack, 1, REGSTACK_INITIAL);
-	(void)ga_grow(&regstack, REGSTACK_INITIAL);
-	regstack.ga_growsize = REGSTACK_INITIAL * 8;
+	ga_init2(&rex.regstack, 1, REGSTACK_INITIAL);
+	(void)ga_grow(&rex.regstack, REGSTACK_INITIAL);
+	rex.regstack.ga_growsize = REGSTACK_INITIAL * 8;
     }
 
-    if (backpos.ga_data == NULL)
+    if (rex.backpos.ga_data == NULL)
     {
-	ga_init2(&backpos, sizeof(backpos_T), BACKPOS_INITIAL);
-	(void)ga_grow(&backpos, BACKPOS_INITIAL);
-	backpos.ga_growsize = BACKPOS_INITIAL * 8;
+	ga_init2(&rex.backpos, sizeof(backpos_T), BACKPOS_INITIAL);
+	(void)ga_grow(&rex.backpos, BACKPOS_INITIAL);
+	rex.backpos.ga_growsize = BACKPOS_INITIAL * 8;
     }
 
     if (REG_MULTI)
@@ -4961,42 +4933,9 @@ bt_regexec_both(
 	rex.reg_icombine = TRUE;
 
     // If there is a "must appear" string, look for it.
-    if (prog->regmust != NULL)
-    {
-	int c;
-
-	if (has_mbyte)
-	    c = (*mb_ptr2char)(prog->regmust);
-	else
-	    c = *prog->regmust;
-	s = line + col;
-
-	// This is used very often, esp. for ":global".  Use three versions of
-	// the loop to avoid overhead of conditions.
-	if (!rex.reg_ic && !has_mbyte)
-	    while ((s = vim_strbyte(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		// Found it.
-		++s;
-	    }
-	else if (!rex.reg_ic || (!enc_utf8 && mb_char2len(c) > 1))
-	    while ((s = vim_strchr(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		// Found it.
-		MB_PTR_ADV(s);
-	    }
-	else
-	    while ((s = cstrchr(s, c)) != NULL)
-	    {
-		if (cstrncmp(s, prog->regmust, &prog->regmlen) == 0)
-		    break;		// Found it.
-		MB_PTR_ADV(s);
-	    }
-	if (s == NULL)		// Not present.
-	    goto theend;
-    }
+    if (prog->regmust != NULL
+		  && reg_find_must(line + col, prog->regmust, prog->regmlen) == NULL)
+	goto theend;
 
     rex.line = line;
     rex.lnum = 0;
@@ -5073,14 +5012,11 @@ bt_regexec_both(
     }
 
 theend:
-    // Free "reg_tofree" when it's a bit big.
     // Free regstack and backpos if they are bigger than their initial size.
-    if (reg_tofreelen > 400)
-	VIM_CLEAR(reg_tofree);
-    if (regstack.ga_maxlen > REGSTACK_INITIAL)
-	ga_clear(&regstack);
-    if (backpos.ga_maxlen > BACKPOS_INITIAL)
-	ga_clear(&backpos);
+    if (rex.regstack.ga_maxlen > REGSTACK_INITIAL)
+	ga_clear(&rex.regstack);
+    if (rex.backpos.ga_maxlen > BACKPOS_INITIAL)
+	ga_clear(&rex.backpos);
 
     if (retval > 0)
     {
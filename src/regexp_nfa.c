@@ -257,12 +257,6 @@ static int wants_nfa;
 static int nstate;	// Number of states in the NFA.
 static int istate;	// Index in the state vector, used in alloc_state()
 
-// If not NULL match must end at this position
-static save_se_T *nfa_endp = NULL;
-
-// 0 for first call to nfa_regmatch(), 1 for recursive call.
-static int nfa_ll_index = 0;
-
 static int realloc_post_list(void);
 static int nfa_reg(int paren);
 #ifdef DEBUG
@@ -4099,12 +4093,6 @@ pim_info(nfa_pim_T *pim)
 
 #endif
 
-// Used during execution: whether a match has been found.
-static int	    nfa_match;
-#ifdef FEAT_RELTIME
-static int	   *nfa_timed_out;
-#endif
-
 static void copy_sub(regsub_T *to, regsub_T *from);
 static int pim_equal(nfa_pim_T *one, nfa_pim_T *two);
 
@@ -4300,13 +4288,13 @@ nfa_did_time_out(void)
 {
     if (*timeout_flag)
     {
-	if (nfa_timed_out != NULL)
+	if (rex.nfa_timed_out != NULL)
 	{
 # ifdef FEAT_EVAL
-	    if (!*nfa_timed_out)
+	    if (!*rex.nfa_timed_out)
 		ch_log(NULL, "NFA regexp timed out");
 # endif
-	    *nfa_timed_out = TRUE;
+	    *rex.nfa_timed_out = TRUE;
 	}
 	return TRUE;
     }
@@ -4514,7 +4502,7 @@ state_in_list(
     nfa_state_T		*state,	// state to update
     regsubs_T		*subs)	// pointers to subexpressions
 {
-    if (state->lastlist[nfa_ll_index] == l->id)
+    if (state->lastlist[rex.nfa_ll_index] == l->id)
     {
 	if (!rex.nfa_has_backref || has_state_with_pos(l, state, subs, NULL))
 	    return TRUE;
@@ -4617,9 +4605,9 @@ addstate(
 	    // next line for a look-behind match.
 	    if (rex.input > rex.line
 		    && *rex.input != NUL
-		    && (nfa_endp == NULL
+		    && (rex.nfa_endp == NULL
 			|| !REG_MULTI
-			|| rex.lnum == nfa_endp->se_u.pos.lnum))
+			|| rex.lnum == rex.nfa_endp->se_u.pos.lnum))
 		goto skip_add;
 	    // FALLTHROUGH
 
@@ -4651,7 +4639,8 @@ addstate(
 	    // endless loop for "\(\)*"
 
 	default:
-	    if (state->lastlist[nfa_ll_index] == l->id && state->c != NFA_SKIP)
+	    if (state->lastlist[rex.nfa_ll_index] == l->id
+						      && state->c != NFA_SKIP)
 	    {
 		// This state is already in the list, don't add it again,
 		// unless it is an MOPEN that is used for a backreference or
@@ -4729,7 +4718,7 @@ skip_add:
 	    }
 
 	    // add the state to the list
-	    state->lastlist[nfa_ll_index] = l->id;
+	    state->lastlist[rex.nfa_ll_index] = l->id;
 	    thread = &l->t[l->n++];
 	    thread->state = state;
 	    if (pim == NULL)
@@ -5332,9 +5321,9 @@ recursive_regmatch(
 {
     int		save_reginput_col = (int)(rex.input - rex.line);
     int		save_reglnum = rex.lnum;
-    int		save_nfa_match = nfa_match;
+    int		save_nfa_match = rex.nfa_match;
     int		save_nfa_listid = rex.nfa_listid;
-    save_se_T   *save_nfa_endp = nfa_endp;
+    save_se_T   *save_nfa_endp = rex.nfa_endp;
     save_se_T   endpos;
     save_se_T   *endposp = NULL;
     int		result;
@@ -5424,7 +5413,7 @@ recursive_regmatch(
 #endif
     // Have to clear the lastlist field of the NFA nodes, so that
     // nfa_regmatch() and addstate() can run properly after recursion.
-    if (nfa_ll_index == 1)
+    if (rex.nfa_ll_index == 1)
     {
 	// Already calling nfa_regmatch() recursively.  Save the lastlist[1]
 	// values and clear them.
@@ -5448,21 +5437,21 @@ recursive_regmatch(
 	// First recursive nfa_regmatch() call, switch to the second lastlist
 	// entry.  Make sure rex.nfa_listid is different from a previous
 	// recursive call, because some states may still have this ID.
-	++nfa_ll_index;
+	++rex.nfa_ll_index;
 	if (rex.nfa_listid <= rex.nfa_alt_listid)
 	    rex.nfa_listid = rex.nfa_alt_listid;
     }
 
     // Call nfa_regmatch() to check if the current concat matches at this
     // position. The concat ends with the node NFA_END_INVISIBLE
-    nfa_endp = endposp;
+    rex.nfa_endp = endposp;
     result = nfa_regmatch(prog, state->out, submatch, m);
 
     if (need_restore)
 	nfa_restore_listids(prog, *listids);
     else
     {
-	--nfa_ll_index;
+	--rex.nfa_ll_index;
 	rex.nfa_alt_listid = rex.nfa_listid;
     }
 
@@ -5473,10 +5462,10 @@ recursive_regmatch(
     rex.input = rex.line + save_reginput_col;
     if (result != NFA_TOO_EXPENSIVE)
     {
-	nfa_match = save_nfa_match;
+	rex.nfa_match = save_nfa_match;
 	rex.nfa_listid = save_nfa_listid;
     }
-    nfa_endp = save_nfa_endp;
+    rex.nfa_endp = save_nfa_endp;
 
 #ifdef ENABLE_LOG
     open_debug_log(result);
@@ -5792,7 +5781,7 @@ nfa_regmatch(
 	return FALSE;
     }
 #endif
-    nfa_match = FALSE;
+    rex.nfa_match = FALSE;
 
     // Allocate memory for the lists of nodes.
     size = (prog->nstate + 1) * sizeof(nfa_thread_T);
@@ -5848,7 +5837,7 @@ nfa_regmatch(
 	r = addstate(thislist, start, m, NULL, 0);
     if (r == NULL)
     {
-	nfa_match = NFA_TOO_EXPENSIVE;
+	rex.nfa_match = NFA_TOO_EXPENSIVE;
 	goto theend;
     }
 
@@ -5897,7 +5886,7 @@ nfa_regmatch(
 		    ))
 	{
 	    // too many states, retry with old engine
-	    nfa_match = NFA_TOO_EXPENSIVE;
+	    rex.nfa_match = NFA_TOO_EXPENSIVE;
 	    goto theend;
 	}
 
@@ -5940,6 +5929,9 @@ nfa_regmatch(
 		break;
 #endif
 	    t = &thislist->t[listidx];
+#ifdef FEAT_PROFILE
+	    ++regprof_nfa_states;
+#endif
 
 #ifdef NFA_REGEXP_DEBUG_LOG
 	    nfa_set_code(t->state->c);
@@ -5980,7 +5972,7 @@ nfa_regmatch(
 			     && rex.input != rex.line && utf_iscomposing(curc))
 		    break;
 
-		nfa_match = TRUE;
+		rex.nfa_match = TRUE;
 		copy_sub(&submatch->norm, &t->subs.norm);
 #ifdef FEAT_SYN_HL
 		if (rex.nfa_has_zsubexpr)
@@ -6013,27 +6005,27 @@ nfa_regmatch(
 		 * Submatches are stored in *m, and used in the parent call.
 		 */
 #ifdef ENABLE_LOG
-		if (nfa_endp != NULL)
+		if (rex.nfa_endp != NULL)
 		{
 		    if (REG_MULTI)
 			fprintf(log_fd, "Current lnum: %d, endp lnum: %d; current col: %d, endp col: %d\n",
 				(int)rex.lnum,
-				(int)nfa_endp->se_u.pos.lnum,
+				(int)rex.nfa_endp->se_u.pos.lnum,
 				(int)(rex.input - rex.line),
-				nfa_endp->se_u.pos.col);
+				rex.nfa_endp->se_u.pos.col);
 		    else
 			fprintf(log_fd, "Current col: %d, endp col: %d\n",
 				(int)(rex.input - rex.line),
-				(int)(nfa_endp->se_u.ptr - rex.input));
+				(int)(rex.nfa_endp->se_u.ptr - rex.input));
 		}
 #endif
 		// If "nfa_endp" is set it's only a match if it ends at
 		// "nfa_endp"
-		if (nfa_endp != NULL && (REG_MULTI
-			? (rex.lnum != nfa_endp->se_u.pos.lnum
+		if (rex.nfa_endp != NULL && (REG_MULTI
+			? (rex.lnum != rex.nfa_endp->se_u.pos.lnum
 			    || (int)(rex.input - rex.line)
-						!= nfa_endp->se_u.pos.col)
-			: rex.input != nfa_endp->se_u.ptr))
+						!= rex.nfa_endp->se_u.pos.col)
+			: rex.input != rex.nfa_endp->se_u.ptr))
 		    break;
 
 		// do not set submatches for \@!
@@ -6049,7 +6041,7 @@ nfa_regmatch(
 		fprintf(log_fd, "Match found:\n");
 		log_subsexpr(m);
 #endif
-		nfa_match = TRUE;
+		rex.nfa_match = TRUE;
 		// See comment above at "goto nextchar".
 		if (nextlist->n == 0)
 		    clen = 0;
@@ -6095,7 +6087,7 @@ nfa_regmatch(
 					  submatch, m, &listids, &listids_len);
 			if (result == NFA_TOO_EXPENSIVE)
 			{
-			    nfa_match = result;
+			    rex.nfa_match = result;
 			    goto theend;
 			}
 
@@ -6156,7 +6148,7 @@ nfa_regmatch(
 			if (addstate_here(thislist, t->state->out1->out,
 					     &t->subs, &pim, &listidx) == NULL)
 			{
-			    nfa_match = NFA_TOO_EXPENSIVE;
+			    rex.nfa_match = NFA_TOO_EXPENSIVE;
 			    goto theend;
 			}
 		    }
@@ -6217,7 +6209,7 @@ nfa_regmatch(
 					  submatch, m, &listids, &listids_len);
 		if (result == NFA_TOO_EXPENSIVE)
 		{
-		    nfa_match = result;
+		    rex.nfa_match = result;
 		    goto theend;
 		}
 		if (result)
@@ -7149,7 +7141,7 @@ nfa_regmatch(
 		}
 		if (r == NULL)
 		{
-		    nfa_match = NFA_TOO_EXPENSIVE;
+		    rex.nfa_match = NFA_TOO_EXPENSIVE;
 		    goto theend;
 		}
 	    }
@@ -7164,19 +7156,19 @@ nfa_regmatch(
 	// because recursive calls should only start in the first position.
 	// Unless "nfa_endp" is not NULL, then we match the end position.
 	// Also don't start a match past the first line.
-	if (nfa_match == FALSE
+	if (rex.nfa_match == FALSE
 		&& ((toplevel
 			&& rex.lnum == 0
 			&& clen != 0
 			&& (rex.reg_maxcol == 0
 			  || (colnr_T)(rex.input - rex.line) < rex.reg_maxcol))
-		    || (nfa_endp != NULL
+		    || (rex.nfa_endp != NULL
 			&& (REG_MULTI
-			    ? (rex.lnum < nfa_endp->se_u.pos.lnum
-			       || (rex.lnum == nfa_endp->se_u.pos.lnum
+			    ? (rex.lnum < rex.nfa_endp->se_u.pos.lnum
+			       || (rex.lnum == rex.nfa_endp->se_u.pos.lnum
 				   && (int)(rex.input - rex.line)
-						    < nfa_endp->se_u.pos.col))
-			    : rex.input < nfa_endp->se_u.ptr))))
+						< rex.nfa_endp->se_u.pos.col))
+			    : rex.input < rex.nfa_endp->se_u.ptr))))
 	{
 #ifdef ENABLE_LOG
 	    fprintf(log_fd, "(---) STARTSTATE\n");
@@ -7233,7 +7225,7 @@ nfa_regmatch(
 			m->norm.list.line[0].start = rex.input + clen;
 		    if (addstate(nextlist, start->out, m, NULL, clen) == NULL)
 		    {
-			nfa_match = NFA_TOO_EXPENSIVE;
+			rex.nfa_match = NFA_TOO_EXPENSIVE;
 			goto theend;
 		    }
 		}
@@ -7242,7 +7234,7 @@ nfa_regmatch(
 	    {
 		if (addstate(nextlist, start, m, NULL, clen) == NULL)
 		{
-		    nfa_match = NFA_TOO_EXPENSIVE;
+		    rex.nfa_match = NFA_TOO_EXPENSIVE;
 		    goto theend;
 		}
 	    }
@@ -7264,8 +7256,8 @@ nextchar:
 	// finish.
 	if (clen != 0)
 	    rex.input += clen;
-	else if (go_to_nextline || (nfa_endp != NULL && REG_MULTI
-					&& rex.lnum < nfa_endp->se_u.pos.lnum))
+	else if (go_to_nextline || (rex.nfa_endp != NULL && REG_MULTI
+				    && rex.lnum < rex.nfa_endp->se_u.pos.lnum))
 	    reg_nextline();
 	else
 	    break;
@@ -7296,7 +7288,745 @@ theend:
     fclose(debug);
 #endif
 
-    return nfa_match;
+    return rex.nfa_match;
+}
+
+/*
+ * A lazily built DFA is used to quickly find out that a line cannot contain a
+ * match, so that nfa_regmatch() only needs to run for lines that may match.
+ *
+ * A DFA state is the set of NFA states that are active at a position.  The
+ * next DFA state for a character is computed the first time it is needed and
+ * then cached, further lines are then checked with one table lookup per
+ * character.  The DFA can only tell that there is no match.  Items it cannot
+ * check, such as "\<", "\%23l" and classes depending on 'iskeyword', are
+ * assumed to match.  Patterns with a backreference, "\@=" and friends or
+ * composing characters are not checked this way, see nfa_dfa_possible().
+ *
+ * To keep the transition tables small, the characters below 256 are put into
+ * classes that all NFA states handle the same way.  All other characters use
+ * one extra class, composing characters another one.
+ */
+
+#define DFA_MAX_STATES	200	// flush the DFA when it has more states
+#define DFA_MAX_FLUSH	5	// stop using the DFA after this many flushes
+#define DFA_HASH_SIZE	64	// number of hash buckets, power of two
+#define DFA_WIDE_CHAR	0x100	// stands for characters above 255
+
+typedef struct nfa_dstate_S nfa_dstate_T;
+
+struct nfa_dstate_S
+{
+    nfa_dstate_T    *ds_hashnext;   // next state with the same hash
+    nfa_dstate_T    **ds_next;	    // next state for each character class,
+				    // NULL when not computed yet
+    int		    ds_flags;	    // DS_ flags below
+    int		    ds_nids;	    // number of NFA states in ds_ids[]
+    int		    ds_ids[1];	    // NFA state numbers, sorted; actually
+				    // longer
+};
+
+#define DS_MATCH	1   // the NFA_MATCH state is in the set
+#define DS_EOL_MATCH	2   // can match at the end of the line
+#define DS_NEWL		4   // can continue in the next line
+
+struct nfa_dfa_S
+{
+    int		    dfa_key;	    // "rex.reg_ic" and 'encoding' used for
+				    // the character classes
+    int		    dfa_flushed;    // number of times states were flushed
+    int		    dfa_nstates;    // number of states in dfa_hash[]
+    int		    dfa_nclass;	    // number of classes for chars < 256
+    short	    dfa_class[256]; // character class of each char
+    int		    dfa_rep[256];   // a character in each class
+    nfa_dstate_T    *dfa_start[2];  // start state, [1]: at start of line
+    nfa_dstate_T    *dfa_hash[DFA_HASH_SIZE];
+
+    // Used while building a state, each "nstate" items.
+    int		    dfa_gen;	    // generation used in dfa_mark[]
+    int		    *dfa_mark;	    // dfa_gen when NFA state was visited
+    int		    *dfa_ids;	    // NFA states of the new DFA state
+    nfa_state_T	    **dfa_stack;    // NFA states to visit
+};
+
+/*
+ * Return TRUE when the DFA can be used for "prog": it does not contain an
+ * item that depends on what matched before or after a position.
+ */
+    static int
+nfa_dfa_possible(nfa_regprog_T *prog)
+{
+    int		i;
+    int		c;
+
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	c = prog->state[i].c;
+	if (c >= 0
+		|| (c >= NFA_MOPEN && c <= NFA_MCLOSE9)
+#ifdef FEAT_SYN_HL
+		|| (c >= NFA_ZOPEN && c <= NFA_ZCLOSE9)
+#endif
+		|| (c >= NFA_ANY && c <= NFA_NUPPER_IC)
+		|| (c >= NFA_CURSOR && c <= NFA_CLASS_FNAME))
+	    continue;
+	switch (c)
+	{
+	    case NFA_SPLIT:
+	    case NFA_MATCH:
+	    case NFA_EMPTY:
+	    case NFA_START_COLL:
+	    case NFA_END_COLL:
+	    case NFA_START_NEG_COLL:
+	    case NFA_RANGE_MIN:
+	    case NFA_RANGE_MAX:
+	    case NFA_BOL:
+	    case NFA_EOL:
+	    case NFA_BOW:
+	    case NFA_EOW:
+	    case NFA_BOF:
+	    case NFA_EOF:
+	    case NFA_NEWL:
+	    case NFA_ZSTART:
+	    case NFA_ZEND:
+	    case NFA_NOPEN:
+	    case NFA_NCLOSE:
+		break;
+	    default:
+		return FALSE;
+	}
+    }
+    return TRUE;
+}
+
+/*
+ * Return TRUE if NFA state "state" consumes a character.
+ */
+    static int
+dfa_is_char_state(nfa_state_T *state)
+{
+    return state->c >= 0
+	    || state->c == NFA_START_COLL
+	    || state->c == NFA_START_NEG_COLL
+	    || (state->c >= NFA_ANY && state->c <= NFA_NUPPER_IC);
+}
+
+/*
+ * Return TRUE if collection "coll" may match character "c".
+ */
+    static int
+dfa_coll_match(nfa_state_T *coll, int c)
+{
+    nfa_state_T	*state;
+    int		result_if_matched = (coll->c == NFA_START_COLL);
+    int		c1, c2;
+
+    if (c == DFA_WIDE_CHAR)
+	return TRUE;
+    for (state = coll->out; state->c != NFA_END_COLL; state = state->out)
+    {
+	if (state->c == NFA_RANGE_MIN)
+	{
+	    c1 = state->val;
+	    state = state->out; // advance to NFA_RANGE_MAX
+	    c2 = state->val;
+	    if (c >= c1 && c <= c2)
+		return result_if_matched;
+	    if (rex.reg_ic)
+	    {
+		int c_low = MB_CASEFOLD(c);
+
+		// Do not loop over a huge range for every character.
+		if (c2 - c1 > 0x400)
+		    return TRUE;
+		for ( ; c1 <= c2; ++c1)
+		    if (MB_CASEFOLD(c1) == c_low)
+			return result_if_matched;
+	    }
+	}
+	else if (state->c == NFA_CLASS_PRINT || state->c == NFA_CLASS_IDENT
+		|| state->c == NFA_CLASS_KEYWORD || state->c == NFA_CLASS_FNAME)
+	    // depends on an option that may change at any time
+	    return TRUE;
+	else if (state->c < 0 ? check_char_class(state->c, c)
+		: (c == state->c
+		    || (rex.reg_ic && MB_CASEFOLD(c) == MB_CASEFOLD(state->c))))
+	    return result_if_matched;
+    }
+    return !result_if_matched;
+}
+
+/*
+ * Return TRUE if NFA state "state", which consumes a character, may match
+ * character "c".  DFA_WIDE_CHAR stands for any character above 255.
+ * This must be in line with what nfa_regmatch() does, but when in doubt
+ * return TRUE.
+ */
+    static int
+dfa_char_match(nfa_state_T *state, int c)
+{
+    switch (state->c)
+    {
+	case NFA_ANY:
+	    return TRUE;
+	case NFA_START_COLL:
+	case NFA_START_NEG_COLL:
+	    return dfa_coll_match(state, c);
+	case NFA_IDENT:
+	case NFA_KWORD:
+	case NFA_FNAME:
+	case NFA_PRINT:
+	    // depends on an option that may change at any time
+	    return TRUE;
+	case NFA_SIDENT:
+	case NFA_SKWORD:
+	case NFA_SFNAME:
+	case NFA_SPRINT:
+	    return !VIM_ISDIGIT(c);
+	case NFA_WHITE:	    return VIM_ISWHITE(c);
+	case NFA_NWHITE:    return !VIM_ISWHITE(c);
+	case NFA_DIGIT:	    return ri_digit(c);
+	case NFA_NDIGIT:    return !ri_digit(c);
+	case NFA_HEX:	    return ri_hex(c);
+	case NFA_NHEX:	    return !ri_hex(c);
+	case NFA_OCTAL:	    return ri_octal(c);
+	case NFA_NOCTAL:    return !ri_octal(c);
+	case NFA_WORD:	    return ri_word(c);
+	case NFA_NWORD:	    return !ri_word(c);
+	case NFA_HEAD:	    return ri_head(c);
+	case NFA_NHEAD:	    return !ri_head(c);
+	case NFA_ALPHA:	    return ri_alpha(c);
+	case NFA_NALPHA:    return !ri_alpha(c);
+	case NFA_LOWER:	    return ri_lower(c);
+	case NFA_NLOWER:    return !ri_lower(c);
+	case NFA_UPPER:	    return ri_upper(c);
+	case NFA_NUPPER:    return !ri_upper(c);
+	case NFA_LOWER_IC:
+	    return ri_lower(c) || (rex.reg_ic && ri_upper(c));
+	case NFA_NLOWER_IC:
+	    return !(ri_lower(c) || (rex.reg_ic && ri_upper(c)));
+	case NFA_UPPER_IC:
+	    return ri_upper(c) || (rex.reg_ic && ri_lower(c));
+	case NFA_NUPPER_IC:
+	    return !(ri_upper(c) || (rex.reg_ic && ri_lower(c)));
+    }
+
+    // regular character
+    if (c == DFA_WIDE_CHAR)
+	return state->c >= DFA_WIDE_CHAR || rex.reg_ic;
+    return state->c == c
+		  || (rex.reg_ic && MB_CASEFOLD(state->c) == MB_CASEFOLD(c));
+}
+
+/*
+ * Free all DFA states, keep the character classes.
+ */
+    static void
+dfa_flush(nfa_dfa_T *dfa)
+{
+    int		    i;
+    nfa_dstate_T    *ds;
+
+    for (i = 0; i < DFA_HASH_SIZE; ++i)
+	while (dfa->dfa_hash[i] != NULL)
+	{
+	    ds = dfa->dfa_hash[i];
+	    dfa->dfa_hash[i] = ds->ds_hashnext;
+	    vim_free(ds->ds_next);
+	    vim_free(ds);
+	}
+    dfa->dfa_start[0] = NULL;
+    dfa->dfa_start[1] = NULL;
+    dfa->dfa_nstates = 0;
+}
+
+    static void
+nfa_dfa_free(nfa_regprog_T *prog)
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+
+    if (dfa == NULL)
+	return;
+    dfa_flush(dfa);
+    vim_free(dfa->dfa_mark);
+    vim_free(dfa->dfa_ids);
+    vim_free(dfa->dfa_stack);
+    VIM_CLEAR(prog->dfa);
+}
+
+/*
+ * Put the characters below 256 in classes: two characters are in the same
+ * class when every NFA state of "prog" matches both or neither of them.
+ * Returns FAIL when out of memory.
+ */
+    static int
+dfa_init_classes(nfa_regprog_T *prog)
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    int		nchar = 0;
+    int		len;
+    char_u	*sigs;
+    char_u	*sig;
+    int		c;
+    int		i;
+    int		k;
+
+    for (i = 0; i < prog->nstate; ++i)
+	if (dfa_is_char_state(&prog->state[i]))
+	    ++nchar;
+
+    // The signature of a character has a bit for each NFA state that
+    // consumes a character, set when it matches that character.
+    len = (nchar + 7) / 8;
+    if (len == 0)
+	len = 1;
+    sigs = lalloc(len * 257, FALSE);
+    if (sigs == NULL)
+	return FAIL;
+
+    // NUL is never looked up.
+    dfa->dfa_nclass = 0;
+    dfa->dfa_class[NUL] = 0;
+    for (c = 1; c < 256; ++c)
+    {
+	sig = sigs + len * dfa->dfa_nclass;
+	vim_memset(sig, 0, len);
+	nchar = 0;
+	for (i = 0; i < prog->nstate; ++i)
+	    if (dfa_is_char_state(&prog->state[i]))
+	    {
+		if (dfa_char_match(&prog->state[i], c))
+		    sig[nchar / 8] |= 1 << (nchar % 8);
+		++nchar;
+	    }
+	for (k = 0; k < dfa->dfa_nclass; ++k)
+	    if (memcmp(sigs + len * k, sig, len) == 0)
+		break;
+	if (k == dfa->dfa_nclass)
+	    dfa->dfa_rep[dfa->dfa_nclass++] = c;
+	dfa->dfa_class[c] = k;
+    }
+    vim_free(sigs);
+    return OK;
+}
+
+/*
+ * Add NFA state "state" and the states that can be reached from it without
+ * consuming a character to the DFA state being built.
+ * At the start of the line "^" matches.  At the end of the line "$" matches,
+ * otherwise it is kept to be used at the end of the line.
+ */
+    static void
+dfa_add_closure(
+    nfa_regprog_T   *prog,
+    nfa_state_T	    *state,
+    int		    *nids,
+    int		    at_bol,
+    int		    at_eol)
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    int		sp = 0;
+    int		c;
+
+    if (dfa->dfa_mark[state - prog->state] == dfa->dfa_gen)
+	return;
+    dfa->dfa_mark[state - prog->state] = dfa->dfa_gen;
+    dfa->dfa_stack[sp++] = state;
+
+    while (sp > 0)
+    {
+	state = dfa->dfa_stack[--sp];
+	c = state->c;
+	if (dfa_is_char_state(state) || c == NFA_MATCH || c == NFA_NEWL
+						   || (c == NFA_EOL && !at_eol))
+	{
+	    dfa->dfa_ids[(*nids)++] = (int)(state - prog->state);
+	    continue;
+	}
+	if (c == NFA_BOL && !at_bol)
+	    continue;
+
+	// Other states match without consuming a character, or are assumed
+	// to match.
+	if (state->out != NULL
+		&& dfa->dfa_mark[state->out - prog->state] != dfa->dfa_gen)
+	{
+	    dfa->dfa_mark[state->out - prog->state] = dfa->dfa_gen;
+	    dfa->dfa_stack[sp++] = state->out;
+	}
+	if (c == NFA_SPLIT && state->out1 != NULL
+		&& dfa->dfa_mark[state->out1 - prog->state] != dfa->dfa_gen)
+	{
+	    dfa->dfa_mark[state->out1 - prog->state] = dfa->dfa_gen;
+	    dfa->dfa_stack[sp++] = state->out1;
+	}
+    }
+}
+
+    static int
+dfa_id_compare(const void *s1, const void *s2)
+{
+    return *(int *)s1 - *(int *)s2;
+}
+
+/*
+ * Find or create the DFA state for the "nids" NFA states in "dfa_ids".
+ * Returns NULL when there are too many DFA states or out of memory.
+ */
+    static nfa_dstate_T *
+dfa_find_state(nfa_regprog_T *prog, int nids)
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *ds;
+    nfa_dstate_T    **hashp;
+    unsigned	    hash = 0;
+    int		    nids_end;
+    int		    i;
+
+    qsort(dfa->dfa_ids, (size_t)nids, sizeof(int), dfa_id_compare);
+    for (i = 0; i < nids; ++i)
+	hash = hash * 31 + dfa->dfa_ids[i];
+    hashp = &dfa->dfa_hash[hash & (DFA_HASH_SIZE - 1)];
+    for (ds = *hashp; ds != NULL; ds = ds->ds_hashnext)
+	if (ds->ds_nids == nids
+		&& memcmp(ds->ds_ids, dfa->dfa_ids, nids * sizeof(int)) == 0)
+	    return ds;
+
+    if (dfa->dfa_nstates >= DFA_MAX_STATES)
+	return NULL;
+    ds = lalloc(offsetof(nfa_dstate_T, ds_ids) + (nids + 1) * sizeof(int),
+									FALSE);
+    if (ds == NULL)
+	return NULL;
+    ds->ds_next = LALLOC_CLEAR_MULT(nfa_dstate_T *, dfa->dfa_nclass + 2);
+    if (ds->ds_next == NULL)
+    {
+	vim_free(ds);
+	return NULL;
+    }
+    ds->ds_nids = nids;
+    mch_memmove(ds->ds_ids, dfa->dfa_ids, nids * sizeof(int));
+
+    ds->ds_flags = 0;
+    for (i = 0; i < nids; ++i)
+	if (prog->state[ds->ds_ids[i]].c == NFA_MATCH)
+	    ds->ds_flags |= DS_MATCH;
+	else if (prog->state[ds->ds_ids[i]].c == NFA_NEWL)
+	    ds->ds_flags |= DS_NEWL;
+
+    // Find out what can match after a "$" at the end of the line.
+    ++dfa->dfa_gen;
+    nids_end = 0;
+    for (i = 0; i < nids; ++i)
+	if (prog->state[ds->ds_ids[i]].c == NFA_EOL)
+	    dfa_add_closure(prog, prog->state[ds->ds_ids[i]].out, &nids_end,
+								  TRUE, TRUE);
+    for (i = 0; i < nids_end; ++i)
+	if (prog->state[dfa->dfa_ids[i]].c == NFA_MATCH)
+	    ds->ds_flags |= DS_EOL_MATCH;
+	else if (prog->state[dfa->dfa_ids[i]].c == NFA_NEWL)
+	    ds->ds_flags |= DS_NEWL;
+
+    ds->ds_hashnext = *hashp;
+    *hashp = ds;
+    ++dfa->dfa_nstates;
+    return ds;
+}
+
+/*
+ * Compute the DFA state that follows "ds" for character class "k".
+ * Returns NULL when there are too many DFA states or out of memory.
+ */
+    static nfa_dstate_T *
+dfa_next_state(nfa_regprog_T *prog, nfa_dstate_T *ds, int k)
+{
+    nfa_dfa_T	*dfa = prog->dfa;
+    nfa_state_T	*state;
+    int		c;
+    int		nids = 0;
+    int		i;
+
+    ++dfa->dfa_gen;
+    if (k == dfa->dfa_nclass + 1)
+    {
+	// A composing character may be skipped together with the character
+	// before it, thus the current states also remain.
+	for (i = 0; i < ds->ds_nids; ++i)
+	{
+	    dfa->dfa_mark[ds->ds_ids[i]] = dfa->dfa_gen;
+	    dfa->dfa_ids[nids++] = ds->ds_ids[i];
+	}
+	c = DFA_WIDE_CHAR;
+    }
+    else if (k == dfa->dfa_nclass)
+	c = DFA_WIDE_CHAR;
+    else
+	c = dfa->dfa_rep[k];
+
+    for (i = 0; i < ds->ds_nids; ++i)
+    {
+	state = &prog->state[ds->ds_ids[i]];
+	if (dfa_is_char_state(state) && dfa_char_match(state, c))
+	    dfa_add_closure(prog, state->c == NFA_START_COLL
+				       || state->c == NFA_START_NEG_COLL
+				       ? state->out1->out : state->out,
+							&nids, FALSE, FALSE);
+    }
+
+    // A match may start at any position.
+    dfa_add_closure(prog, prog->start, &nids, FALSE, FALSE);
+    return dfa_find_state(prog, nids);
+}
+
+/*
+ * Mark the states of "prog" that can be reached from the start state with
+ * "gen" in "mark[]".  States already marked with "gen" are not entered.
+ * Returns TRUE when the NFA_MATCH state can be reached.
+ * Only for patterns where nfa_dfa_possible() is TRUE.
+ */
+    static int
+nfa_mark_reachable(
+    nfa_regprog_T   *prog,
+    int		    *mark,
+    int		    gen,
+    nfa_state_T	    **stack)
+{
+    nfa_state_T	*state;
+    nfa_state_T	*next[2];
+    int		sp = 0;
+    int		found = FALSE;
+    int		i;
+
+    if (mark[prog->start - prog->state] != gen)
+    {
+	mark[prog->start - prog->state] = gen;
+	stack[sp++] = prog->start;
+    }
+    while (sp > 0)
+    {
+	state = stack[--sp];
+	next[0] = NULL;
+	next[1] = NULL;
+	if (state->c == NFA_MATCH)
+	    found = TRUE;
+	else if (state->c == NFA_SPLIT)
+	{
+	    next[0] = state->out;
+	    next[1] = state->out1;
+	}
+	else if (state->c == NFA_START_COLL || state->c == NFA_START_NEG_COLL)
+	    next[0] = state->out1->out;
+	else
+	    next[0] = state->out;
+	for (i = 0; i < 2; ++i)
+	    if (next[i] != NULL && mark[next[i] - prog->state] != gen)
+	    {
+		mark[next[i] - prog->state] = gen;
+		stack[sp++] = next[i];
+	    }
+    }
+    return found;
+}
+
+/*
+ * Find the longest literal text that every match of "prog" contains.  Return
+ * it in allocated memory, or NULL when there is none.
+ * Only done when the DFA can be used and the pattern cannot match a line
+ * break, thus the text must be in the line where the match starts.
+ */
+    static char_u *
+nfa_get_must_text(nfa_regprog_T *prog)
+{
+    int		*reach;
+    int		*mark;
+    nfa_state_T	**stack;
+    nfa_state_T	*state;
+    nfa_state_T	*p;
+    nfa_state_T	*best = NULL;
+    int		bestlen = 0;
+    int		len;
+    int		gen = 0;
+    int		i;
+    char_u	*ret = NULL;
+    char_u	*s;
+
+    // Checking each state is O(nstate^2), skip very big patterns.
+    if (!prog->dfa_ok || prog->nstate > 1000)
+	return NULL;
+    for (i = 0; i < prog->nstate; ++i)
+	if (prog->state[i].c == NFA_NEWL)
+	    return NULL;
+
+    reach = ALLOC_CLEAR_MULT(int, prog->nstate);
+    mark = ALLOC_CLEAR_MULT(int, prog->nstate);
+    stack = ALLOC_MULT(nfa_state_T *, prog->nstate);
+    if (reach == NULL || mark == NULL || stack == NULL)
+	goto theend;
+
+    // Find the states used at all, items inside [] are not.
+    nfa_mark_reachable(prog, reach, 1, stack);
+
+    for (i = 0; i < prog->nstate; ++i)
+    {
+	state = &prog->state[i];
+	if (state->c <= 0 || reach[i] != 1)
+	    continue;
+
+	// Length of the characters matched in sequence from here, skipping
+	// over zero-width items such as "\(" and "\<".
+	len = 0;
+	for (p = state; p != NULL && len < 200; )
+	{
+	    if (p->c > 0)
+		len += MB_CHAR2LEN(p->c);
+	    else if (p->c == NFA_SPLIT || p->c == NFA_MATCH || p->c == 0
+							|| dfa_is_char_state(p))
+		break;
+	    p = p->out;
+	}
+	if (len <= bestlen)
+	    continue;
+
+	// Every match contains the text when the NFA_MATCH state cannot be
+	// reached without passing this state.
+	++gen;
+	mark[i] = gen;
+	if (!nfa_mark_reachable(prog, mark, gen, stack))
+	{
+	    best = state;
+	    bestlen = len;
+	}
+    }
+
+    // A single character that is the regstart is already checked for.
+    if (best == NULL || (best->c == prog->regstart
+					   && bestlen == MB_CHAR2LEN(best->c)))
+	goto theend;
+
+    ret = alloc(bestlen + 1);
+    if (ret == NULL)
+	goto theend;
+    s = ret;
+    for (p = best; s < ret + bestlen; p = p->out)
+	if (p->c > 0)
+	{
+	    if (has_mbyte)
+		s += (*mb_char2bytes)(p->c, s);
+	    else
+		*s++ = p->c;
+	}
+    *s = NUL;
+
+theend:
+    vim_free(reach);
+    vim_free(mark);
+    vim_free(stack);
+    return ret;
+}
+
+/*
+ * Return FALSE if "prog" cannot match in "rex.line" at or after column "col".
+ * Return TRUE when it may match, or when the DFA cannot be used.
+ */
+    static int
+nfa_dfa_may_match(nfa_regprog_T *prog, colnr_T col)
+{
+    nfa_dfa_T	    *dfa = prog->dfa;
+    nfa_dstate_T    *ds;
+    nfa_dstate_T    *next;
+    char_u	    *p;
+    int		    key;
+    int		    at_bol = (col == 0);
+    int		    nids = 0;
+    int		    c;
+    int		    k;
+
+    if (dfa == NULL)
+    {
+	dfa = ALLOC_CLEAR_ONE(nfa_dfa_T);
+	if (dfa == NULL)
+	    return TRUE;
+	prog->dfa = dfa;
+	dfa->dfa_key = -1;
+	dfa->dfa_mark = LALLOC_CLEAR_MULT(int, prog->nstate);
+	dfa->dfa_ids = LALLOC_MULT(int, prog->nstate);
+	dfa->dfa_stack = LALLOC_MULT(nfa_state_T *, prog->nstate);
+	if (dfa->dfa_mark == NULL || dfa->dfa_ids == NULL
+						     || dfa->dfa_stack == NULL)
+	{
+	    nfa_dfa_free(prog);
+	    prog->dfa_ok = FALSE;
+	    return TRUE;
+	}
+    }
+
+    // The character classes depend on 'ignorecase' and 'encoding'.
+    key = (rex.reg_ic ? 1 : 0) + (enc_utf8 ? 2 : 0) + (has_mbyte ? 4 : 0)
+							       + enc_dbcs * 8;
+    if (dfa->dfa_key != key)
+    {
+	dfa_flush(dfa);
+	if (dfa_init_classes(prog) == FAIL)
+	    return TRUE;
+	dfa->dfa_key = key;
+    }
+    else if (dfa->dfa_nstates >= DFA_MAX_STATES)
+    {
+	// Too many states for this pattern, start all over.  When this
+	// happens too often the DFA is not useful.
+	if (++dfa->dfa_flushed > DFA_MAX_FLUSH)
+	{
+	    nfa_dfa_free(prog);
+	    prog->dfa_ok = FALSE;
+	    return TRUE;
+	}
+	dfa_flush(dfa);
+    }
+
+    ds = dfa->dfa_start[at_bol];
+    if (ds == NULL)
+    {
+	++dfa->dfa_gen;
+	dfa_add_closure(prog, prog->start, &nids, at_bol, FALSE);
+	ds = dfa_find_state(prog, nids);
+	if (ds == NULL)
+	    return TRUE;
+	dfa->dfa_start[at_bol] = ds;
+    }
+
+    for (p = rex.line + col; ; )
+    {
+	if (ds->ds_flags & DS_MATCH)
+	    return TRUE;
+	if (*p == NUL)
+	    break;
+	if (*p < 0x80 || !has_mbyte)
+	    k = dfa->dfa_class[*p++];
+	else
+	{
+	    c = (*mb_ptr2char)(p);
+	    if (c < 0x100)
+		k = dfa->dfa_class[c];
+	    else if (enc_utf8 && utf_iscomposing(c))
+		k = dfa->dfa_nclass + 1;
+	    else
+		k = dfa->dfa_nclass;
+	    p += enc_utf8 ? utf_ptr2len(p) : (*mb_ptr2len)(p);
+	}
+
+	next = ds->ds_next[k];
+	if (next == NULL)
+	{
+	    next = dfa_next_state(prog, ds, k);
+	    if (next == NULL)
+		return TRUE;
+	    ds->ds_next[k] = next;
+	}
+	ds = next;
+    }
+
+    return (ds->ds_flags & DS_EOL_MATCH)
+				   || ((ds->ds_flags & DS_NEWL) && REG_MULTI);
 }
 
 /*
@@ -7319,7 +8049,7 @@ nfa_regtry(
 
     rex.input = rex.line + col;
 #ifdef FEAT_RELTIME
-    nfa_timed_out = timed_out;
+    rex.nfa_timed_out = timed_out;
 #endif
 
 #ifdef ENABLE_LOG
@@ -7540,6 +8270,14 @@ nfa_regexec_both(
     if (rex.reg_maxcol > 0 && col >= rex.reg_maxcol)
 	goto theend;
 
+    // Quickly check whether a match is possible at all: look for the text
+    // every match must contain, then run the DFA.
+    if (prog->must_text != NULL && reg_find_must(rex.line + col,
+		 prog->must_text, (int)STRLEN(prog->must_text)) == NULL)
+	goto theend;
+    if (prog->dfa_ok && !rex.reg_line_lbr && !nfa_dfa_may_match(prog, col))
+	goto theend;
+
     // Set the "nstate" used by nfa_regcomp() to zero to trigger an error when
     // it's accidentally used during execution.
     nstate = 0;
@@ -7665,6 +8403,9 @@ nfa_regcomp(char_u *expr, int re_flags)
     prog->reganch = nfa_get_reganch(prog->start, 0);
     prog->regstart = nfa_get_regstart(prog->start, 0);
     prog->match_text = nfa_get_match_text(prog->start);
+    prog->dfa_ok = nfa_dfa_possible(prog);
+    prog->dfa = NULL;
+    prog->must_text = nfa_get_must_text(prog);
 
 #ifdef ENABLE_LOG
     nfa_postfix_dump(expr, OK);
@@ -7705,7 +8446,9 @@ nfa_regfree(regprog_T *prog)
     if (prog == NULL)
 	return;
 
+    nfa_dfa_free((nfa_regprog_T *)prog);
     vim_free(((nfa_regprog_T *)prog)->match_text);
+    vim_free(((nfa_regprog_T *)prog)->must_text);
     vim_free(((nfa_regprog_T *)prog)->pattern);
     vim_free(prog);
 }
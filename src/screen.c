@@ -614,6 +614,10 @@ screen_line(
 #ifdef FEAT_GUI_MSWIN
     changed_next = redraw_next;
 #endif
+#ifdef FEAT_PROFILE
+    if (redrawstats_on)
+	redrawstats.rs_cells += endcol - col;
+#endif
 
     while (col < endcol)
     {
@@ -787,6 +791,11 @@ skip_opacity:
 
 	if (redraw_this)
 	{
+#ifdef FEAT_PROFILE
+	    if (redrawstats_on)
+		redrawstats.rs_changed += char_cells;
+#endif
+
 	    /*
 	     * Special handling when 'xs' termcap flag set (hpterm):
 	     * Attributes for characters are stored at the position where the
@@ -3360,33 +3369,40 @@ line_was_clobbered(int screen_lnum)
 }
 
 /*
- * Copy part of a Screenline for vertically split window "wp".
+ * Copy "width" screen cells from offset "off_from" to offset "off_to".
  */
     static void
-linecopy(int to, int from, win_T *wp)
+linecopy_off(unsigned off_to, unsigned off_from, int width)
 {
-    unsigned	off_to = LineOffset[to] + wp->w_wincol;
-    unsigned	off_from = LineOffset[from] + wp->w_wincol;
-
     mch_memmove(ScreenLines + off_to, ScreenLines + off_from,
-	    wp->w_width * sizeof(schar_T));
+	    width * sizeof(schar_T));
     if (enc_utf8)
     {
 	int	i;
 
 	mch_memmove(ScreenLinesUC + off_to, ScreenLinesUC + off_from,
-		wp->w_width * sizeof(u8char_T));
+		width * sizeof(u8char_T));
 	for (i = 0; i < p_mco; ++i)
 	    mch_memmove(ScreenLinesC[i] + off_to, ScreenLinesC[i] + off_from,
-		    wp->w_width * sizeof(u8char_T));
+		    width * sizeof(u8char_T));
     }
     if (enc_dbcs == DBCS_JPNU)
 	mch_memmove(ScreenLines2 + off_to, ScreenLines2 + off_from,
-		wp->w_width * sizeof(schar_T));
+		width * sizeof(schar_T));
     mch_memmove(ScreenAttrs + off_to, ScreenAttrs + off_from,
-	    wp->w_width * sizeof(sattr_T));
+	    width * sizeof(sattr_T));
     mch_memmove(ScreenCols + off_to, ScreenCols + off_from,
-	    wp->w_width * sizeof(colnr_T));
+	    width * sizeof(colnr_T));
+}
+
+/*
+ * Copy part of a Screenline for vertically split window "wp".
+ */
+    static void
+linecopy(int to, int from, win_T *wp)
+{
+    linecopy_off(LineOffset[to] + wp->w_wincol,
+				LineOffset[from] + wp->w_wincol, wp->w_width);
 }
 
 /*
@@ -3854,6 +3870,65 @@ win_del_lines(
     return OK;
 }
 
+/*
+ * Move screen line "from" of window "wp" to screen line "to", only output the
+ * characters that differ.
+ */
+    static void
+win_copy_line(win_T *wp, int from, int to)
+{
+    linecopy_off((unsigned)(current_ScreenLine - ScreenLines),
+		    LineOffset[W_WINROW(wp) + from] + wp->w_wincol, wp->w_width);
+    screen_line(wp, W_WINROW(wp) + to, wp->w_wincol, wp->w_width,
+						     -wp->w_width, (colnr_T)0, 0);
+    LineWraps[W_WINROW(wp) + to] = FALSE;
+}
+
+/*
+ * Insert or delete "line_count" lines at "row" in window "wp" without using
+ * the terminal to scroll: the lines that remain visible are copied from
+ * ScreenLines[] to their new row.  This avoids that win_update() has to draw
+ * all the buffer lines again with win_line().
+ * Returns FAIL when this can't be done, e.g. when text of a popup window may
+ * be in the moved lines.
+ */
+    static int
+win_copy_lines(
+    win_T	*wp,
+    int		row,
+    int		line_count,
+    int		del,
+    int		clear_attr)
+{
+    int		i;
+
+    if (!screen_valid(FALSE) || pum_visible()
+#ifdef FEAT_PROP_POPUP
+	    || popup_may_cover_win(wp)
+#endif
+       )
+	return FAIL;
+
+    // Move the lines that remain visible, clear the lines that became empty
+    // like the terminal would do.
+    if (del)
+    {
+	for (i = row; i + line_count < wp->w_height; ++i)
+	    win_copy_line(wp, i + line_count, i);
+	screen_fill(W_WINROW(wp) + wp->w_height - line_count,
+		W_WINROW(wp) + wp->w_height,
+		wp->w_wincol, (int)W_ENDCOL(wp), ' ', ' ', clear_attr);
+    }
+    else
+    {
+	for (i = wp->w_height - 1; i - line_count >= row; --i)
+	    win_copy_line(wp, i - line_count, i);
+	screen_fill(W_WINROW(wp) + row, W_WINROW(wp) + row + line_count,
+		wp->w_wincol, (int)W_ENDCOL(wp), ' ', ' ', clear_attr);
+    }
+    return OK;
+}
+
 /*
  * Common code for win_ins_lines() and win_del_lines().
  * Returns OK or FAIL when the work has been done.
@@ -3888,9 +3963,9 @@ win_do_lines(
     }
 
 #ifdef FEAT_PROP_POPUP
-    // this doesn't work when there are popups visible
+    // Scrolling the terminal doesn't work when there are popups visible.
     if (popup_visible)
-	return FAIL;
+	return win_copy_lines(wp, row, line_count, del, clear_attr);
 #endif
 
     // Delete all remaining lines
@@ -3913,7 +3988,7 @@ win_do_lines(
     // Terminal scroll operations affect the full screen width, which would
     // corrupt the vertical tabpanel area and cause flicker.
     if (tabpanel_width() > 0)
-	return FAIL;
+	return win_copy_lines(wp, row, line_count, del, clear_attr);
 #endif
 
     /*
@@ -3939,6 +4014,11 @@ win_do_lines(
 	if (scroll_region && (wp->w_width == topframe->fr_width
 		    || *T_CSV != NUL))
 	    scroll_region_reset();
+	// In a vertically split window without t_CV too many lines to redraw
+	// them from ScreenLines[], copying only outputs what changed.
+	if (retval == FAIL && wp->w_width != topframe->fr_width
+							     && *T_CSV == NUL)
+	    retval = win_copy_lines(wp, row, line_count, del, clear_attr);
 	return retval;
     }
 
@@ -451,11 +451,24 @@ struct u_entry
     linenr_T	ue_lcount;	// linecount when u_save called
     undoline_T	*ue_array;	// array of lines in undo block
     long	ue_size;	// number of lines in ue_array
+    char_u	*ue_text;	// text of all lines in ue_array when not
+				// allocated separately, or NULL
 #ifdef U_DEBUG
     int		ue_magic;	// magic number to check allocation
 #endif
 };
 
+/*
+ * Used by u_savesub_batch() to add lines to one undo entry.
+ */
+typedef struct
+{
+    buf_T	*ub_buf;	// buffer "ub_entry" is for
+    u_entry_T	*ub_entry;	// entry to add lines to, NULL at the start
+    long	ub_alloc;	// number of lines allocated in ue_array
+    linenr_T	ub_lcount;	// line count when the entry was last used
+} u_batch_T;
+
 struct u_header
 {
     // The following have a pointer and a number. The number is used when
@@ -529,18 +542,17 @@ typedef struct memfile	    memfile_T;
 typedef long		    blocknr_T;
 
 /*
- * mf_hashtab_T is a chained hashtable with blocknr_T key and arbitrary
- * structures as items.  This is an intrusive data structure: we require
- * that items begin with mf_hashitem_T which contains the key and linked
- * list pointers.  List of items in each bucket is doubly-linked.
+ * mf_hashtab_T is an open addressing hashtable with blocknr_T key and
+ * arbitrary structures as items.  This is an intrusive data structure: we
+ * require that items begin with mf_hashitem_T which contains the key.  The
+ * array holds pointers to the items, NULL for an unused slot.  Collisions are
+ * resolved with linear probing.
  */
 
 typedef struct mf_hashitem_S mf_hashitem_T;
 
 struct mf_hashitem_S
 {
-    mf_hashitem_T   *mhi_next;
-    mf_hashitem_T   *mhi_prev;
     blocknr_T	    mhi_key;
 };
 
@@ -585,13 +597,15 @@ struct block_hdr
 #define BH_DIRTY    1
 #define BH_LOCKED   2
     char	bh_flags;	    // BH_DIRTY or BH_LOCKED
+    int		bh_pinned;	    // nr of pinned lines, block is not released
+				    // while non-zero, see ml_pin_line()
 };
 
 /*
  * when a block with a negative number is flushed to the file, it gets
  * a positive number. Because the reference to the block is still the negative
  * number, we remember the translation to the new positive number in the
- * double linked trans lists. The structure is the same as the hash lists.
+ * trans hashtable. The structure is the same as the block hashtable.
  */
 typedef struct nr_trans NR_TRANS;
 
@@ -870,9 +884,22 @@ typedef struct memline
     chunksize_T *ml_chunksize;
     int		ml_numchunks;
     int		ml_usedchunks;
+    chunksize_T *ml_chunktree;	// binary indexed tree over ml_chunksize[]
+    int		ml_chunktree_valid; // ml_chunktree matches ml_chunksize[]
 #endif
 } memline_T;
 
+/*
+ * A line obtained with ml_pin_line().  It stays valid when other lines are
+ * obtained with ml_get(), until ml_unpin_line() is called.  The buffer must
+ * not be changed in between.
+ */
+typedef struct
+{
+    bhdr_T	*lp_hp;		// pinned data block or NULL
+    char_u	*lp_alloc;	// allocated copy of the line or NULL
+} linepin_T;
+
 // Values for the flags argument of ml_delete_flags().
 #define ML_DEL_MESSAGE	    1	// may give a "No lines in buffer" message
 #define ML_DEL_UNDO	    2	// called from undo, do not update textprops
@@ -3017,6 +3044,26 @@ typedef struct {
 } syn_time_T;
 #endif
 
+#ifdef FEAT_PROFILE
+/*
+ * Used for ":redrawstats": counters for redrawing the screen.
+ */
+typedef struct {
+    long	rs_updates;	// nr of update_screen() calls
+    long	rs_clear;	// nr of times the screen was cleared
+    long	rs_win_updates;	// nr of win_update() calls
+    long	rs_win_full;	// nr of those redrawing the whole window
+    long	rs_lines;	// nr of buffer lines drawn with win_line()
+    long	rs_cells;	// nr of cells compared in screen_line()
+    long	rs_changed;	// nr of those cells that were changed
+    long	rs_bytes;	// nr of bytes written to the terminal
+    long	rs_flushes;	// nr of writes to the terminal
+    proftime_T	rs_time;	// time spent in update_screen()
+    proftime_T	rs_syn_time;	// time spent on syntax highlighting
+    proftime_T	rs_popup_time;	// time spent in update_popups()
+} redrawstats_T;
+#endif
+
 typedef struct timer_S timer_T;
 struct timer_S
 {
@@ -3104,6 +3151,7 @@ typedef struct {
     int		b_syn_error;		// TRUE when error occurred in HL
 # ifdef FEAT_RELTIME
     int		b_syn_slow;		// TRUE when 'redrawtime' reached
+    int		b_syn_ahead_slow;	// TRUE when parsing ahead timed out
 # endif
     int		b_syn_ic;		// ignore case for :syn cmds
     int		b_syn_foldlevel;	// how to compute foldlevel on a line
@@ -3154,6 +3202,13 @@ typedef struct {
     int		b_sst_freecount;
     linenr_T	b_sst_check_lnum;
     short_u	b_sst_lasttick;	// last display tick
+# ifdef FEAT_PROFILE
+    // For ":syntime report": how syntax_start() got the state for a line.
+    long	b_sst_from_prev;	// continued from the previous line
+    long	b_sst_from_stored;	// started at a saved state
+    long	b_sst_synced;		// had to synchronize
+    long	b_sst_parsed;		// lines parsed to get there
+# endif
 #endif // FEAT_SYN_HL
 
 #ifdef FEAT_SPELL
@@ -4442,6 +4497,14 @@ struct window_S
     int		w_hl_len;
     int		w_hlfwin_id; // Cached HLF_WIN highlight group id, zero if none,
 			     // or -1 if it was set to itself.
+
+#ifdef FEAT_PROFILE
+    // for ":redrawstats"
+    long	w_rs_updates;	    // nr of win_update() calls
+    long	w_rs_full;	    // nr of those redrawing the whole window
+    long	w_rs_lines;	    // nr of buffer lines drawn
+    proftime_T	w_rs_time;	    // time spent in win_update()
+#endif
 };
 
 /*
@@ -56,6 +56,10 @@ typedef struct syn_pattern
     int		 sp_sync_idx;		// sync item index (syncing only)
     int		 sp_line_id;		// ID of last line where tried
     int		 sp_startcol;		// next match in sp_line_id line
+    lpos_T	 sp_m_startpos;		// start of that match, lnum is zero
+					// when it can't be used again
+    lpos_T	 sp_m_endpos;		// end of that match
+    int		 sp_has_zs;		// pattern contains "\zs"
     short	*sp_cont_list;		// cont. group IDs, if non-zero
     short	*sp_next_list;		// next group IDs, if non-zero
     struct sp_syn sp_syn;		// struct passed to in_id_list()
@@ -277,6 +281,22 @@ static int	current_line_id = 0;	// unique number for current line
 
 #define CUR_STATE(idx)	((stateitem_T *)(current_state.ga_data))[idx]
 
+#ifdef FEAT_RELTIME
+/*
+ * Parsing ahead of the displayed lines while waiting for a character.
+ * syn_ahead_tm is set while syn_parse_ahead() calls syntax_start().  The
+ * others remember how far parsing got for which buffer and change.
+ */
+# define SYN_AHEAD_LINES 10000	// parse this many lines below the window
+# define SYN_AHEAD_MSEC	10L	// time to parse before checking for input
+# define SYN_AHEAD_MAX_MSEC 50L	// regexp time limit while parsing ahead
+static proftime_T   *syn_ahead_tm = NULL;
+static synblock_T   *syn_ahead_block = NULL;
+static buf_T	    *syn_ahead_buf = NULL;
+static varnumber_T  syn_ahead_changedtick = 0;
+static linenr_T	    syn_ahead_lnum = 0;
+#endif
+
 static void syn_sync(win_T *wp, linenr_T lnum, synstate_T *last_valid);
 static int syn_match_linecont(linenr_T lnum);
 static void syn_start_line(void);
@@ -414,6 +434,10 @@ syntax_start(win_T *wp, linenr_T lnum)
 	 */
 	if (current_lnum != lnum)
 	    invalidate_current_state();
+#ifdef FEAT_PROFILE
+	else if (syn_time_on)
+	    ++syn_block->b_sst_from_prev;
+#endif
     }
     else
 	invalidate_current_state();
@@ -432,12 +456,23 @@ syntax_start(win_T *wp, linenr_T lnum)
 	    if (p->sst_lnum <= lnum && p->sst_change_lnum == 0)
 	    {
 		last_valid = p;
-		if (p->sst_lnum >= lnum - syn_block->b_syn_sync_minlines)
+		if (p->sst_lnum >= lnum - syn_block->b_syn_sync_minlines
+#ifdef FEAT_RELTIME
+			// when parsing ahead continue where we stopped
+			|| syn_ahead_tm != NULL
+#endif
+			)
 		    last_min_valid = p;
 	    }
 	}
 	if (last_min_valid != NULL)
+	{
 	    load_current_state(last_min_valid);
+#ifdef FEAT_PROFILE
+	    if (syn_time_on)
+		++syn_block->b_sst_from_stored;
+#endif
+	}
     }
 
     /*
@@ -446,6 +481,10 @@ syntax_start(win_T *wp, linenr_T lnum)
      */
     if (INVALID_STATE(&current_state))
     {
+#ifdef FEAT_PROFILE
+	if (syn_time_on)
+	    ++syn_block->b_sst_synced;
+#endif
 	syn_sync(wp, lnum, last_valid);
 	if (current_lnum == 1)
 	    // First line is always valid, no matter "minlines".
@@ -470,7 +509,20 @@ syntax_start(win_T *wp, linenr_T lnum)
     {
 	syn_start_line();
 	(void)syn_finish_line(FALSE);
+#ifdef FEAT_RELTIME
+	// When parsing ahead and a pattern timed out the state is wrong, don't
+	// store it.
+	if (syn_ahead_tm != NULL && syn_block->b_syn_ahead_slow)
+	{
+	    invalidate_current_state();
+	    break;
+	}
+#endif
 	++current_lnum;
+#ifdef FEAT_PROFILE
+	if (syn_time_on)
+	    ++syn_block->b_sst_parsed;
+#endif
 
 	// If we parsed at least "minlines" lines or started at a valid
 	// state, the current state is considered valid.
@@ -515,6 +567,18 @@ syntax_start(win_T *wp, linenr_T lnum)
 		prev = store_current_state();
 	}
 
+#ifdef FEAT_RELTIME
+	// When parsing ahead stop when the time is up, keeping the state to
+	// continue from next time.
+	if (syn_ahead_tm != NULL && current_lnum < lnum
+					 && profile_passed_limit(syn_ahead_tm))
+	{
+	    if (current_lnum >= first_stored)
+		(void)store_current_state();
+	    break;
+	}
+#endif
+
 	// This can take a long time: break when CTRL-C pressed.  The current
 	// state will be wrong then.
 	line_breakcheck();
@@ -528,6 +592,67 @@ syntax_start(win_T *wp, linenr_T lnum)
     syn_start_line();
 }
 
+#if defined(FEAT_RELTIME) || defined(PROTO)
+/*
+ * Called while waiting for a character to be typed: parse the lines below
+ * the ones displayed in the current window, so that the saved states are
+ * there when scrolling down or jumping ahead.  Only parses for a short time,
+ * the next call continues where this one stopped.
+ * Returns TRUE when there is more to parse.
+ */
+    int
+syn_parse_ahead(void)
+{
+    win_T	*wp = curwin;
+    buf_T	*buf = wp->w_buffer;
+    linenr_T	target;
+    linenr_T	prev_lnum = 0;
+    proftime_T	tm;
+
+    if (!syntax_present(wp) || wp->w_s->b_syn_slow
+		|| wp->w_s->b_syn_ahead_slow || updating_screen
+		|| buf->b_ml.ml_mfp == NULL)
+	return FALSE;
+
+    target = wp->w_botline + SYN_AHEAD_LINES;
+    if (target > buf->b_ml.ml_line_count)
+	target = buf->b_ml.ml_line_count;
+    if (target < wp->w_botline)
+	return FALSE;
+
+    if (syn_ahead_block == wp->w_s && syn_ahead_buf == buf
+			    && syn_ahead_changedtick == CHANGEDTICK(buf))
+    {
+	if (syn_ahead_lnum >= target)
+	    return FALSE;
+	prev_lnum = syn_ahead_lnum;
+    }
+
+    // Stop parsing between lines after SYN_AHEAD_MSEC, and abort a slow
+    // pattern after SYN_AHEAD_MAX_MSEC, a typed character must not wait long.
+    profile_setlimit(SYN_AHEAD_MSEC, &tm);
+    syn_ahead_tm = &tm;
+    init_regexp_timeout(SYN_AHEAD_MAX_MSEC);
+    syntax_start(wp, target);
+    disable_regexp_timeout();
+    syn_ahead_tm = NULL;
+    if (wp->w_s->b_syn_ahead_slow)
+	// A pattern timed out, don't try again until CTRL-L or ":syntax".
+	return FALSE;
+
+    syn_ahead_block = wp->w_s;
+    syn_ahead_buf = buf;
+    syn_ahead_changedtick = CHANGEDTICK(buf);
+    // Give up when not getting any further, e.g. because re-syncing takes
+    // all the time.
+    if (current_lnum >= target || current_lnum <= prev_lnum)
+	syn_ahead_lnum = target;
+    else
+	syn_ahead_lnum = current_lnum;
+    return syn_ahead_lnum < target;
+}
+#endif
+
 /*
  * We cannot simply discard growarrays full of state_items or buf_states; we
  * have to manually release their extmatch pointers first.
@@ -1035,6 +1160,10 @@ syn_stack_free_block(synblock_T *block)
     VIM_CLEAR(block->b_sst_array);
     block->b_sst_first = NULL;
     block->b_sst_len = 0;
+#ifdef FEAT_RELTIME
+    if (syn_ahead_block == block)
+	syn_ahead_block = NULL;
+#endif
 }
 /*
  * Free b_sst_array[] for buffer "buf".
@@ -1059,6 +1188,187 @@ syn_stack_free_all(synblock_T *block)
 #endif
 }
 
+/*
+ * The saved states of a buffer while it is being reloaded.  Only the b_sst_
+ * members of syn_reload_block are used.
+ */
+static buf_T	    *syn_reload_buf = NULL;
+static synblock_T   syn_reload_block;
+static long_u	    syn_reload_hash;
+
+#define HASH_ADD(h, n)	((h) = (h) * 31 + (long_u)(n))
+
+/*
+ * Add the IDs in "list" to hash "h".
+ */
+    static long_u
+syn_id_list_hash(long_u h, short *list)
+{
+    if (list != NULL)
+	while (*list != 0)
+	    HASH_ADD(h, *list++);
+    return HASH_ADD(h, 0);
+}
+
+/*
+ * Compute a number from the syntax items of "buf" that changes when the
+ * items are defined differently or keywords are matched differently.  Used to
+ * check if saved states still apply after the syntax was cleared and defined
+ * again.
+ */
+    static long_u
+syn_items_hash(buf_T *buf)
+{
+    synblock_T	*block = &buf->b_s;
+    long_u	h = 0;
+    int		idx;
+    synpat_T	*spp;
+    syn_cluster_T *scl;
+    hashtab_T	*ht;
+    hashitem_T	*hi;
+    keyentry_T	*kp;
+    long	todo;
+    int		i;
+
+    HASH_ADD(h, block->b_syn_ic);
+    HASH_ADD(h, block->b_syn_containedin);
+    HASH_ADD(h, block->b_syn_sync_flags);
+    HASH_ADD(h, block->b_syn_sync_id);
+    HASH_ADD(h, block->b_syn_sync_minlines);
+    HASH_ADD(h, block->b_syn_sync_maxlines);
+    HASH_ADD(h, block->b_syn_sync_linebreaks);
+    if (block->b_syn_linecont_pat != NULL)
+	HASH_ADD(h, hash_hash(block->b_syn_linecont_pat));
+    // ":syntax iskeyword" or else 'iskeyword' decides what a keyword is
+    HASH_ADD(h, hash_hash(block->b_syn_isk != empty_option
+					   ? block->b_syn_isk : buf->b_p_isk));
+
+    for (idx = 0; idx < block->b_syn_patterns.ga_len; ++idx)
+    {
+	spp = &(SYN_ITEMS(block)[idx]);
+	HASH_ADD(h, spp->sp_type);
+	HASH_ADD(h, spp->sp_syncing);
+	HASH_ADD(h, spp->sp_syn_match_id);
+	HASH_ADD(h, spp->sp_off_flags);
+	for (i = 0; i < SPO_COUNT; ++i)
+	    HASH_ADD(h, spp->sp_offsets[i]);
+	HASH_ADD(h, spp->sp_flags);
+	HASH_ADD(h, spp->sp_ic);
+	HASH_ADD(h, spp->sp_sync_idx);
+	HASH_ADD(h, spp->sp_syn.inc_tag);
+	HASH_ADD(h, spp->sp_syn.id);
+	h = syn_id_list_hash(h, spp->sp_syn.cont_in_list);
+	h = syn_id_list_hash(h, spp->sp_cont_list);
+	h = syn_id_list_hash(h, spp->sp_next_list);
+	HASH_ADD(h, hash_hash(spp->sp_pattern));
+    }
+
+    for (idx = 0; idx < block->b_syn_clusters.ga_len; ++idx)
+    {
+	scl = &(SYN_CLSTR(block)[idx]);
+	if (scl->scl_name != NULL)
+	    HASH_ADD(h, hash_hash(scl->scl_name));
+	h = syn_id_list_hash(h, scl->scl_list);
+    }
+
+    for (i = 0; i < 2; ++i)
+    {
+	ht = i == 0 ? &block->b_keywtab : &block->b_keywtab_ic;
+	todo = (long)ht->ht_used;
+	FOR_ALL_HASHTAB_ITEMS(ht, hi, todo)
+	{
+	    if (HASHITEM_EMPTY(hi))
+		continue;
+	    --todo;
+	    for (kp = HI2KE(hi); kp != NULL; kp = kp->ke_next)
+	    {
+		HASH_ADD(h, hash_hash(kp->keyword));
+		HASH_ADD(h, kp->k_syn.inc_tag);
+		HASH_ADD(h, kp->k_syn.id);
+		h = syn_id_list_hash(h, kp->k_syn.cont_in_list);
+		h = syn_id_list_hash(h, kp->next_list);
+		HASH_ADD(h, kp->flags);
+	    }
+	}
+    }
+    return h;
+}
+
+/*
+ * Called before reloading buffer "buf": take away its saved states, so that
+ * clearing the syntax doesn't free them.  The syntax is usually defined
+ * again the same way and the start of the file is often unchanged, then
+ * syn_stack_reload_restore() can use them again.
+ */
+    void
+syn_stack_reload_save(buf_T *buf)
+{
+    synblock_T	*block = &buf->b_s;
+
+    syn_stack_free_block(&syn_reload_block);
+    syn_reload_buf = NULL;
+    if (block->b_sst_first == NULL)
+	return;
+
+    syn_reload_buf = buf;
+    syn_reload_hash = syn_items_hash(buf);
+    syn_reload_block.b_sst_array = block->b_sst_array;
+    syn_reload_block.b_sst_len = block->b_sst_len;
+    syn_reload_block.b_sst_first = block->b_sst_first;
+    syn_reload_block.b_sst_firstfree = block->b_sst_firstfree;
+    syn_reload_block.b_sst_freecount = block->b_sst_freecount;
+    block->b_sst_array = NULL;
+    block->b_sst_first = NULL;
+    block->b_sst_len = 0;
+    if (syn_block == block)
+	invalidate_current_state();
+}
+
+/*
+ * Called after reloading buffer "buf", "lnum" is the first line that is
+ * different.  Put back the states taken by syn_stack_reload_save() if the
+ * syntax items are the same as before, without the ones from "lnum" on.
+ */
+    void
+syn_stack_reload_restore(buf_T *buf, linenr_T lnum)
+{
+    synblock_T	*block = &buf->b_s;
+    synstate_T	*p, *np, *prev = NULL;
+
+    if (syn_reload_buf == buf && block->b_sst_array == NULL
+				   && syn_items_hash(buf) == syn_reload_hash)
+    {
+	block->b_sst_array = syn_reload_block.b_sst_array;
+	block->b_sst_len = syn_reload_block.b_sst_len;
+	block->b_sst_first = syn_reload_block.b_sst_first;
+	block->b_sst_firstfree = syn_reload_block.b_sst_firstfree;
+	block->b_sst_freecount = syn_reload_block.b_sst_freecount;
+	syn_reload_block.b_sst_array = NULL;
+	syn_reload_block.b_sst_first = NULL;
+
+	// The "nextgroup" list pointers refer to the freed items.
+	for (p = block->b_sst_first; p != NULL; p = np)
+	{
+	    np = p->sst_next;
+	    if (p->sst_lnum + block->b_syn_sync_linebreaks > lnum
+		    || p->sst_change_lnum != 0 || p->sst_next_list != NULL)
+	    {
+		if (prev == NULL)
+		    block->b_sst_first = np;
+		else
+		    prev->sst_next = np;
+		syn_stack_free_entry(block, p);
+	    }
+	    else
+		prev = p;
+	}
+	if (syn_block == block)
+	    invalidate_current_state();
+    }
+    syn_stack_free_block(&syn_reload_block);
+    syn_reload_buf = NULL;
+}
+
 /*
  * Allocate the syntax state stack for syn_buf when needed.
  * If the number of entries in b_sst_array[] is much too big or a bit too
@@ -1953,19 +2263,46 @@ syn_current_attr(
 			    if (spp->sp_line_id == current_line_id
 				    && spp->sp_startcol >= next_match_col)
 				continue;
-			    spp->sp_line_id = current_line_id;
 
 			    lc_col = current_col - spp->sp_offsets[SPO_LC_OFF];
 			    if (lc_col < 0)
 				lc_col = 0;
 
-			    regmatch.rmm_ic = spp->sp_ic;
-			    regmatch.regprog = spp->sp_prog;
-			    r = syn_regexec(&regmatch,
+			    // If the match found before in this line starts at
+			    // or after "lc_col", searching again would find
+			    // the same match.  This avoids matching every
+			    // pattern again each time a match was used.
+			    if (spp->sp_line_id == current_line_id
+				    && spp->sp_m_startpos.lnum != 0
+				    && spp->sp_m_startpos.col >= lc_col)
+			    {
+				regmatch.startpos[0] = spp->sp_m_startpos;
+				regmatch.endpos[0] = spp->sp_m_endpos;
+				r = TRUE;
+			    }
+			    else
+			    {
+				spp->sp_line_id = current_line_id;
+				regmatch.rmm_ic = spp->sp_ic;
+				regmatch.regprog = spp->sp_prog;
+				r = syn_regexec(&regmatch,
 					     current_lnum,
 					     (colnr_T)lc_col,
 					     IF_SYN_TIME(&spp->sp_time));
-			    spp->sp_prog = regmatch.regprog;
+				spp->sp_prog = regmatch.regprog;
+
+				// With "\zs" the match may start before the
+				// reported position and with "\z(" the
+				// external submatches are needed.
+				if (r && !spp->sp_has_zs
+						    && re_extmatch_out == NULL)
+				{
+				    spp->sp_m_startpos = regmatch.startpos[0];
+				    spp->sp_m_endpos = regmatch.endpos[0];
+				}
+				else
+				    spp->sp_m_startpos.lnum = 0;
+			    }
 			    if (!r)
 			    {
 				// no match in this line, try another one
@@ -3184,6 +3521,9 @@ syn_regexec(
 	syn_win->w_s->b_syn_slow = TRUE;
 	msg(_("'redrawtime' exceeded, syntax highlighting disabled"));
     }
+    // When parsing ahead a timeout only stops parsing ahead.
+    if (timed_out && syn_ahead_tm != NULL)
+	syn_win->w_s->b_syn_ahead_slow = TRUE;
 #endif
 
     if (r > 0)
@@ -3487,6 +3827,7 @@ syntax_clear(synblock_T *block)
     block->b_syn_error = FALSE;	    // clear previous error
 #ifdef FEAT_RELTIME
     block->b_syn_slow = FALSE;	    // clear previous timeout
+    block->b_syn_ahead_slow = FALSE;
 #endif
     block->b_syn_ic = FALSE;	    // Use case, by default
     block->b_syn_foldlevel = SYNFLD_START;
@@ -5657,6 +5998,7 @@ get_syn_pattern(char_u *arg, synpat_T *ci)
     if (ci->sp_prog == NULL)
 	return NULL;
     ci->sp_ic = curwin->w_s->b_syn_ic;
+    ci->sp_has_zs = strstr((char *)ci->sp_pattern, "\\zs") != NULL;
 #ifdef FEAT_PROFILE
     syn_clear_time(&ci->sp_time);
 #endif
@@ -6666,6 +7008,10 @@ syntime_clear(void)
 	spp = &(SYN_ITEMS(curwin->w_s)[idx]);
 	syn_clear_time(&spp->sp_time);
     }
+    curwin->w_s->b_sst_from_prev = 0;
+    curwin->w_s->b_sst_from_stored = 0;
+    curwin->w_s->b_sst_synced = 0;
+    curwin->w_s->b_sst_parsed = 0;
 }
 
 /*
@@ -6803,6 +7149,13 @@ syntime_report(void)
 	msg_advance(13);
 	msg_outnum(total_count);
 	msg_puts("\n");
+
+	vim_snprintf((char *)IObuff, IOSIZE,
+		_("Line start state: %ld from previous line, %ld from saved state, %ld synced, %ld lines parsed"),
+		curwin->w_s->b_sst_from_prev, curwin->w_s->b_sst_from_stored,
+		curwin->w_s->b_sst_synced, curwin->w_s->b_sst_parsed);
+	msg_puts((char *)IObuff);
+	msg_puts("\n");
     }
 }
 #endif
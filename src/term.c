@@ -2812,11 +2812,18 @@ termcapinit(char_u *name)
 
 /*
  * The number of calls to ui_write is reduced by using "out_buf".
+ * While redrawing the screen "out_buf" may grow up to OUT_FRAME_SIZE, so that
+ * a whole screen update is written at once, see out_frame_start().
  */
 #define OUT_SIZE	8191
+#define OUT_FRAME_SIZE	(256 * 1024 - 1)
 
 // add one to allow mch_write() in os_win32.c to append a NUL
-static char_u		out_buf[OUT_SIZE + 1];
+static char_u		out_buf_static[OUT_SIZE + 1];
+static char_u		*out_buf = out_buf_static;
+static int		out_alloced = OUT_SIZE; // size of out_buf minus one
+static int		out_size = OUT_SIZE;	// flush when this is reached
+static int		out_frame = 0;		// nesting of out_frame_start()
 
 static int		out_pos = 0;	// number of chars in out_buf
 
@@ -2839,6 +2846,13 @@ out_flush(void)
     len = out_pos;
     out_pos = 0;
     ui_write(out_buf, len, FALSE);
+#ifdef FEAT_PROFILE
+    if (redrawstats_on)
+    {
+	redrawstats.rs_bytes += len;
+	++redrawstats.rs_flushes;
+    }
+#endif
 #ifdef FEAT_EVAL
     if (ch_log_output != FALSE)
     {
@@ -2855,6 +2869,77 @@ out_flush(void)
 #endif
 }
 
+/*
+ * Make "out_buf" bigger while redrawing the screen.
+ * Returns FAIL when not redrawing, the buffer is at its maximum size or out
+ * of memory.  Then the caller needs to flush.
+ */
+    static int
+out_grow(void)
+{
+    int	    newsize;
+    char_u  *p;
+
+    if (out_frame == 0 || out_size >= OUT_FRAME_SIZE)
+	return FAIL;
+    newsize = out_size * 2 + 1;
+    if (newsize > OUT_FRAME_SIZE)
+	newsize = OUT_FRAME_SIZE;
+    if (newsize > out_alloced)
+    {
+	p = alloc(newsize + 1);
+	if (p == NULL)
+	    return FAIL;
+	mch_memmove(p, out_buf, out_pos);
+	if (out_buf != out_buf_static)
+	    vim_free(out_buf);
+	out_buf = p;
+	out_alloced = newsize;
+    }
+    out_size = newsize;
+    return OK;
+}
+
+/*
+ * Called when starting to redraw the screen.  Until the matching
+ * out_frame_end() the output is not flushed when "out_buf" is full, the
+ * buffer grows instead.  Writing the screen update with one write() avoids
+ * many system calls and a partly updated screen, e.g. over a slow ssh
+ * connection.  Can be nested.
+ */
+    void
+out_frame_start(void)
+{
+    ++out_frame;
+}
+
+/*
+ * Called when done redrawing the screen.  The output is not flushed here, the
+ * caller usually still positions the cursor, but output that doesn't fit in
+ * the normal buffer size is flushed on the next byte.
+ */
+    void
+out_frame_end(void)
+{
+    if (out_frame > 0 && --out_frame == 0)
+	out_size = OUT_SIZE;
+}
+
+#if defined(EXITFREE) || defined(PROTO)
+    void
+free_out_buf(void)
+{
+    if (out_buf != out_buf_static)
+    {
+	out_flush();
+	vim_free(out_buf);
+	out_buf = out_buf_static;
+	out_alloced = OUT_SIZE;
+	out_size = OUT_SIZE;
+    }
+}
+#endif
+
 /*
  * out_flush_cursor(): flush the output buffer and redraw the cursor.
  * Does not flush recursively in the GUI to avoid slow drawing.
@@ -2884,7 +2969,8 @@ out_flush_cursor(
     void
 out_flush_check(void)
 {
-    if (enc_dbcs != 0 && out_pos >= OUT_SIZE - MB_MAXBYTES)
+    if (enc_dbcs != 0 && out_pos >= out_size - MB_MAXBYTES
+							 && out_grow() == FAIL)
 	out_flush();
 }
 
@@ -2916,7 +3002,7 @@ out_char(unsigned c)
     out_buf[out_pos++] = c;
 
     // For testing we flush each time.
-    if (out_pos >= OUT_SIZE || p_wd)
+    if ((out_pos >= out_size && out_grow() == FAIL) || p_wd)
 	out_flush();
 }
 
@@ -2928,7 +3014,7 @@ out_char_nf(int c)
 {
     out_buf[out_pos++] = (unsigned)c;
 
-    if (out_pos >= OUT_SIZE)
+    if (out_pos >= out_size && out_grow() == FAIL)
 	out_flush();
     return (unsigned)c;
 }
@@ -2946,7 +3032,7 @@ out_char_nf(int c)
 out_str_nf(char_u *s)
 {
     // avoid terminal strings being split up
-    if (out_pos > OUT_SIZE - MAX_ESC_SEQ_LEN)
+    if (out_pos > out_size - MAX_ESC_SEQ_LEN && out_grow() == FAIL)
 	out_flush();
 
     for (char_u *p = s; *p != NUL; ++p)
@@ -2981,7 +3067,7 @@ out_str_cf(char_u *s)
 	return;
     }
 #endif
-    if (out_pos > OUT_SIZE - MAX_ESC_SEQ_LEN)
+    if (out_pos > out_size - MAX_ESC_SEQ_LEN && out_grow() == FAIL)
 	out_flush();
 #ifdef HAVE_TGETENT
     for (p = s; *s; ++s)
@@ -3049,7 +3135,7 @@ out_str(char_u *s)
     }
 #endif
     // avoid terminal strings being split up
-    if (out_pos > OUT_SIZE - MAX_ESC_SEQ_LEN)
+    if (out_pos > out_size - MAX_ESC_SEQ_LEN && out_grow() == FAIL)
 	out_flush();
 #ifdef HAVE_TGETENT
     tputs((char *)s, 1, TPUTSFUNCAST out_char_nf);
@@ -87,6 +87,30 @@ func Test_crypt_sodium_v2()
   call Crypt_uncrypt('xchacha20v2')
 endfunc
 
+" The last line ends exactly where the write buffer is full, the EOL goes in
+" the next block.  Encryption must only be finished once.
+func Test_crypt_last_line_at_buffer_end()
+  let methods = ['blowfish2']
+  if has('sodium')
+    let methods += ['xchacha20', 'xchacha20v2']
+  endif
+  " the write buffer is 0x10000 bytes
+  let text = ['first line', repeat('x', 0x10000 - 11)]
+  for meth in methods
+    exe 'set cryptmethod=' .. meth
+    new Xtest_boundary.txt
+    call setline(1, text)
+    call feedkeys(":X\<CR>foobar\<CR>foobar\<CR>", 'xt')
+    w!
+    bwipe!
+    call feedkeys(":split Xtest_boundary.txt\<CR>foobar\<CR>", 'xt')
+    call assert_equal(text, getline(1, '$'), meth)
+    set key= cryptmethod&
+    bwipe!
+    call delete('Xtest_boundary.txt')
+  endfor
+endfunc
+
 func Test_crypt_sodium_v2_startup()
   CheckFeature sodium
   CheckRunVimInTerminal
@@ -692,4 +692,48 @@ func Test_change_wrapped_line_cpo_dollar()
   call StopVimInTerminal(buf)
 endfunc
 
+func Test_redrawstats()
+  CheckFeature profile
+
+  redrawstats clear
+  let stats = redrawstats()
+  call assert_equal(0, stats.updates)
+  call assert_equal([], stats.windows)
+
+  new
+  call setline(1, range(1, 10))
+  redrawstats on
+  redraw!
+  call setline(3, 'changed')
+  redraw
+  redrawstats off
+  " not counted when off
+  redraw!
+
+  let stats = redrawstats()
+  call assert_equal(2, stats.updates)
+  call assert_equal(1, stats.clear)
+  call assert_true(stats.winupdates >= 2)
+  call assert_true(stats.winwhole >= 1)
+  call assert_true(stats.lines >= 10)
+  call assert_true(stats.cells >= stats.changed)
+  call assert_true(stats.changed > 0)
+  call assert_equal(v:t_float, type(stats.time))
+  let win = filter(copy(stats.windows), 'v:val.winid == win_getid()')
+  call assert_equal(1, len(win))
+  call assert_equal(bufnr(), win[0].bufnr)
+  " the changed line is drawn when updating again
+  call assert_true(win[0].lines >= 11)
+
+  let report = execute('redrawstats report')
+  call assert_match('Screen updates: 2, cleared: 1', report)
+  call assert_match('TIME *UPDATES *WHOLE *LINES *WINID *BUFFER', report)
+
+  redrawstats clear
+  call assert_equal(0, redrawstats().updates)
+  call assert_equal([], redrawstats().windows)
+  call assert_fails('redrawstats foo', 'E475:')
+  bwipe!
+endfunc
+
 " vim: shiftwidth=2 sts=2 expandtab
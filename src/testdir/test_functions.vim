@@ -1456,6 +1456,41 @@ func Test_byte2line_line2byte()
   bw!
 endfunc
 
+" Test for line2byte() and byte2line() after many scattered changes, these use
+" the cached chunk sizes
+func Test_byte2line_line2byte_many_changes()
+  new
+  call setline(1, map(range(1, 5000), 'repeat("x", v:val % 37)'))
+  call srand(42)
+  for i in range(600)
+    let lnum = rand() % line('$') + 1
+    let r = rand() % 4
+    if r == 0
+      call setline(lnum, getline(lnum) .. 'abc')
+    elseif r == 1
+      call append(lnum, repeat('y', rand() % 50))
+    elseif r == 2
+      exe lnum .. 'delete'
+    else
+      exe lnum .. ',' .. min([lnum + rand() % 500, line('$')]) .. 'delete'
+      call append(lnum - 1, repeat(['zz'], rand() % 600))
+    endif
+  endfor
+
+  for ff in ['unix', 'dos']
+    let &fileformat = ff
+    let off = 1
+    for lnum in range(1, line('$'))
+      call assert_equal(off, line2byte(lnum))
+      call assert_equal(lnum, byte2line(off))
+      let off += len(getline(lnum)) + (ff == 'dos' ? 2 : 1)
+    endfor
+  endfor
+
+  set fileformat&
+  bw!
+endfunc
+
 " Test for byteidx() using a character index
 func Test_byteidx()
   let a = '.é.' " one char of two bytes
@@ -1287,6 +1287,31 @@ func Test_pum_getpos()
   unlet g:pum_pos
 endfunc
 
+" Closing the popup menu only redraws the lines that were below it
+func Test_pum_undisplay_redraw_below()
+  CheckFeature profile
+
+  new
+  call setline(1, ['one', 'two', 'three', ''])
+  set completeopt=menu
+  normal! G
+  redraw
+  redrawstats clear
+  redrawstats on
+  call feedkeys("A\<C-N>\<C-N>\<C-Y>\<Esc>", 'xt')
+  redraw
+  redrawstats off
+  call assert_equal('two', getline(4))
+
+  let stats = redrawstats()
+  call assert_equal(0, stats.clear)
+  call assert_equal(0, stats.winwhole)
+
+  set completeopt&
+  redrawstats clear
+  bw!
+endfunc
+
 " Test for the popup menu with the 'rightleft' option set
 func Test_pum_rightleft()
   CheckFeature rightleft
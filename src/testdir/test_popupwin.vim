@@ -1274,6 +1274,87 @@ func Test_popup_hide()
   bwipe!
 endfunc
 
+" Opening and closing a popup only redraws the lines below it.
+func Test_popup_redraw_below()
+  CheckFeature profile
+
+  call setline(1, range(1, 20))
+  redraw
+  redrawstats clear
+  redrawstats on
+  let winid = popup_create(['one', 'two'], #{line: 3, col: 5})
+  redraw
+  call assert_equal('one', join(map(range(5, 7), 'screenstring(3, v:val)'), ''))
+  call popup_hide(winid)
+  redraw
+  call assert_equal('3', screenstring(3, 1))
+  call assert_equal(' ', screenstring(3, 5))
+  call popup_show(winid)
+  redraw
+  call assert_equal('two', join(map(range(5, 7), 'screenstring(4, v:val)'), ''))
+  call popup_close(winid)
+  redraw
+  call assert_equal('4', screenstring(4, 1))
+  call assert_equal(' ', screenstring(4, 5))
+  redrawstats off
+
+  let stats = redrawstats()
+  call assert_equal(0, stats.clear)
+  let win = filter(stats.windows, 'v:val.winid == win_getid()')
+  call assert_equal(0, win[0].whole)
+  " only the two lines below the popup are redrawn each time
+  call assert_equal(8, win[0].lines)
+
+  redrawstats clear
+  bwipe!
+endfunc
+
+func Test_popup_menu_redraw_below()
+  CheckFeature profile
+
+  call setline(1, range(1, 20))
+  let winid = popup_menu(['one', 'two', 'three'], #{line: 3, col: 5})
+  redraw
+  redrawstats clear
+  redrawstats on
+  call feedkeys("j", 'xt')
+  redraw
+  redrawstats off
+
+  " moving the selection only redraws the popup
+  let stats = redrawstats()
+  call assert_equal(0, stats.clear)
+  let win = filter(stats.windows, 'v:val.winid == win_getid()')
+  call assert_equal(0, win[0].whole)
+  call assert_equal(0, win[0].lines)
+
+  call popup_close(winid)
+  redrawstats clear
+  bwipe!
+endfunc
+
+" Scrolling a window while a popup is visible moves the text on the screen.
+func Test_popup_scroll_window_below()
+  CheckScreendump
+
+  let lines =<< trim END
+      call setline(1, range(1, 100)->map({_, v -> 'line ' .. v}))
+      vsplit
+      call popup_create('popup', #{line: 1, col: &columns - 10})
+  END
+  call writefile(lines, 'XtestPopupScrollBelow', 'D')
+  let buf = RunVimInTerminal('-S XtestPopupScrollBelow', #{rows: 10})
+  call term_sendkeys(buf, "3\<C-E>")
+  call term_sendkeys(buf, "\<C-Y>")
+  call VerifyScreenDump(buf, 'Test_popupwin_scroll_below_1', {})
+
+  call term_sendkeys(buf, "\<C-W>l5\<C-E>")
+  call VerifyScreenDump(buf, 'Test_popupwin_scroll_below_2', {})
+
+  " clean up
+  call StopVimInTerminal(buf)
+endfunc
+
 func Test_popup_move()
   topleft vnew
   call setline(1, 'hello')
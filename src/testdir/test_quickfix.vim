@@ -3250,6 +3250,41 @@ func Test_vimgrep_wildcards_expanded_once()
   bwipe!
 endfunc
 
+" Files that can't match are skipped without loading them
+func Test_vimgrep_skip_files()
+  call writefile(['one', 'the Needle here', 'three'], 'Xvgrskip1', 'D')
+  call writefile(['nothing', 'to see'], 'Xvgrskip2', 'D')
+  call writefile(['a NEEDLE too'], 'Xvgrskip3', 'D')
+  " UTF-16 file, does not contain "Needle" as plain text
+  call writefile(0zfffe4e006500650064006c0065000a00, 'Xvgrskip4', 'D')
+
+  vimgrep /Needle/j Xvgrskip*
+  call assert_equal(['Xvgrskip1', 'Xvgrskip4'],
+	\ getqflist()->map({_, v -> bufname(v.bufnr)}))
+  call assert_equal(['the Needle here'], getqflist()[0:0]->map({_, v -> v.text}))
+
+  vimgrep /\cneedle/j Xvgrskip*
+  call assert_equal(['Xvgrskip1', 'Xvgrskip3', 'Xvgrskip4'],
+	\ getqflist()->map({_, v -> bufname(v.bufnr)}))
+  set ignorecase
+  vimgrep /needle/j Xvgrskip*
+  call assert_equal(3, len(getqflist()))
+  set noignorecase
+
+  " an autocommand may change the text that is searched
+  augroup QF_Test
+    au!
+    autocmd BufReadPost Xvgrskip2 call setline(1, 'Needle')
+  augroup END
+  vimgrep /Needle/j Xvgrskip*
+  call assert_equal(['Xvgrskip1', 'Xvgrskip2', 'Xvgrskip4'],
+	\ getqflist()->map({_, v -> bufname(v.bufnr)}))
+  augroup QF_Test
+    au!
+  augroup END
+  %bwipe!
+endfunc
+
 " Test for incsearch highlighting of the :vimgrep pattern
 " This test used to cause "E315: ml_get: invalid lnum" errors.
 func Test_vimgrep_incsearch()
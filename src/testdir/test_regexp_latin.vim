@@ -125,7 +125,9 @@ endfunc
 
 func Test_out_of_memory()
   new
-  s/^/,n
+  " The text must be able to match, otherwise the DFA check already finds
+  " there is no match.
+  s/^/,n;
   " This will be slow...
   call assert_fails('call search("\\v((n||<)+);")', 'E363:')
 endfunc
@@ -1171,5 +1173,78 @@ def Test_compare_column_matchstr()
   set re=0
 enddef
 
+" A back reference to text in another line must be compared correctly when
+" the lines are in different memline blocks.
+func Test_backref_multi_line_many_blocks()
+  " Use the lines in the data blocks, not allocated copies.
+  call test_override('alloc_lines', 0)
+  for engine in [1, 2]
+    let &regexpengine = engine
+    new
+    for i in range(1, 2000)
+      call append('$', [i .. repeat('x', 40), i .. repeat('x', 40)])
+    endfor
+    call setline(1, 'start')
+    call append('$', 'end')
+    %s/^\(.\+\n\)\1/\1/
+    call assert_equal(2002, line('$'))
+    call assert_equal('1' .. repeat('x', 40), getline(2))
+    call assert_equal('2000' .. repeat('x', 40), getline(2001))
+    call assert_equal(0, search('^\(.\+\n\)\1', 'nw'))
+    bwipe!
+  endfor
+  set regexpengine&
+  call test_override('alloc_lines', 1)
+endfunc
+
+func Test_regprofile()
+  CheckFeature profile
+
+  regprofile clear
+  call assert_equal([], regexpstats())
+  regprofile on
+  call assert_equal('bar', matchstr('foo bar baz', '\%#=1b.r'))
+  call assert_equal('baz', matchstr('foo bar baz', '\%#=2b.z'))
+  call assert_equal('baz', matchstr('foo bar baz', '\%#=2b.z'))
+  call assert_equal('', matchstr('foo bar baz', '\%#=2x.y'))
+  regprofile off
+  " not counted when compiled while profiling is off
+  call assert_equal('foo', matchstr('foo bar baz', '\%#=1f.o'))
+
+  let stats = regexpstats()
+  call assert_equal(3, len(stats))
+  let bystr = {}
+  for entry in stats
+    let bystr[entry.pattern] = entry
+  endfor
+
+  let bt = bystr['b.r']
+  call assert_equal('bt', bt.engine)
+  call assert_equal(1, bt.compiled)
+  call assert_equal(1, bt.count)
+  call assert_equal(1, bt.match)
+  call assert_true(bt.btsteps > 0)
+  call assert_equal(0, bt.nfastates)
+  call assert_true(bt.size > 0)
+  call assert_equal(v:t_float, type(bt.total))
+
+  let nfa = bystr['b.z']
+  call assert_equal('nfa', nfa.engine)
+  call assert_true(nfa.compiled >= 1)
+  call assert_equal(2, nfa.count)
+  call assert_equal(2, nfa.match)
+  call assert_equal(0, nfa.btsteps)
+  call assert_true(nfa.nfastates > 0)
+  call assert_equal(0, nfa.timeouts)
+  call assert_equal(0, bystr['x.y'].match)
+
+  let report = split(execute('regprofile report'), "\n")
+  call assert_match('^  TOTAL *COUNT *MATCH *SLOWEST *STEPS *TIMEOUT', report[0])
+  call assert_equal(4, len(report))
+
+  regprofile clear
+  call assert_equal([], regexpstats())
+  call assert_fails('regprofile foo', 'E475:')
+endfunc
 
 " vim: shiftwidth=2 sts=2 expandtab
@@ -651,4 +651,43 @@ func Test_regex_collection_range_with_composing_crash()
   bwipe!
 endfunc
 
+" The NFA engine first checks with a DFA whether a line can match at all.
+" Check the cases where that check must not reject a match.
+func Test_regexp_nfa_dfa_check()
+  " composing character skipped with the character before it
+  call assert_equal("ae\u0301x", matchstr("ae\u0301x", '\%#=2^a.x'))
+  call assert_equal("e\u0301x", matchstr("1e\u0301x", '\%#=2\a\+x'))
+  " Kelvin sign matches "k" when ignoring case
+  call assert_equal("\u212a", matchstr("a\u212ab", '\%#=2\ck'))
+  call assert_equal('', matchstr("a\u212ab", '\%#=2\Ck'))
+  " end of line and next line
+  call assert_equal('b', matchstr('ab', '\%#=2b$'))
+  call assert_equal('', matchstr('ab', '\%#=2a$'))
+  new
+  call setline(1, ['one two', 'three', 'four'])
+  call assert_equal([1, 5], searchpos('\%#=2two\nthree', 'cw'))
+  call assert_equal([2, 1], searchpos('\%#=2^three$', 'w'))
+  call assert_equal([0, 0], searchpos('\%#=2two$\nfour', 'w'))
+  " using the same pattern with and without 'ignorecase'
+  set ignorecase
+  call assert_equal([2, 1], searchpos('\%#=2THREE', 'w'))
+  set noignorecase
+  call assert_equal([0, 0], searchpos('\%#=2THREE', 'w'))
+  bwipe!
+endfunc
+
+" Both engines first look for literal text that every match must contain.
+func Test_regexp_must_text()
+  for re in range(1, 2)
+    let pre = '\%#=' .. re
+    call assert_equal('xFOO', matchstr('-xFOO', pre .. '\c\w\+foo'))
+    call assert_equal('', matchstr('-xFOO', pre .. '\C\w\+foo'))
+    call assert_equal("xa\u0301b", matchstr("-xa\u0301b", pre .. '\Z\w\+ab'))
+    call assert_equal('', matchstr("-xa\u0301b", pre .. '\w\+ab'))
+    call assert_equal('a;', matchstr('xx a; b', pre .. '\<\a\+;'))
+  endfor
+  " Kelvin sign is longer than "k"
+  call assert_equal("xa\u212a", matchstr("-xa\u212a", '\%#=2\c\w\+ak'))
+endfunc
+
 " vim: shiftwidth=2 sts=2 expandtab
@@ -947,6 +947,57 @@ func Test_substitute_expr()
   call assert_fails("let s=submatch(2, [])", 'E745:')
 endfunc
 
+" Compiled patterns are cached, using the same pattern again must still work
+func Test_substitute_repeated_pattern()
+  let pat = '\(\a\+\)\(\d\)'
+  for i in range(5)
+    call assert_equal('1ab-2cd', substitute('ab1-cd2', pat, '\2\1', 'g'))
+    call assert_equal('cd2', matchstr('-cd2', pat))
+  endfor
+
+  " recursive use of the same pattern
+  func RecurseSame()
+    return substitute('x7', '\(\a\+\)\(\d\)', '\2\1', '')
+  endfunc
+  call assert_equal('7x1ab', substitute('ab1', pat,
+			      \ {-> RecurseSame() .. submatch(2) .. submatch(1)}, ''))
+  call assert_equal('1ab', substitute('ab1', pat, '\2\1', ''))
+  delfunc RecurseSame
+
+  " an error is given every time
+  for i in range(2)
+    call assert_fails("call substitute('a', '\\%#=5a', 'b', '')", 'E864:')
+  endfor
+
+  " [:keyword:] depends on 'iskeyword'
+  let save_isk = &iskeyword
+  let save_re = &regexpengine
+  for re in range(3)
+    let &regexpengine = re
+    set iskeyword+=-
+    call assert_equal('a-b', matchstr('a-b', '[[:keyword:]]\+'))
+    set iskeyword-=-
+    call assert_equal('a', matchstr('a-b', '[[:keyword:]]\+'))
+  endfor
+  let &iskeyword = save_isk
+  let &regexpengine = save_re
+endfunc
+
+" Nested use of both engines with look-behind and back references
+func Test_substitute_nested_engines()
+  func RecurseBoth()
+    return substitute('xaax', '\%#=1\(a\)\@<=a', 'b', '')
+	  \ .. substitute('xaax', '\%#=2\(a\)\@<=a', 'c', '')
+  endfunc
+  for re in range(3)
+    let &regexpengine = re
+    call assert_equal('-xabxxacx-', substitute('aa', '\(a\)\1',
+	  \ {-> '-' .. RecurseBoth() .. '-'}, ''))
+  endfor
+  set regexpengine&
+  delfunc RecurseBoth
+endfunc
+
 func Test_invalid_submatch()
   " This was causing invalid memory access in Vim-7.4.2232 and older
   call assert_fails("call substitute('x', '.', {-> submatch(10)}, '')", 'E935:')
@@ -1526,4 +1577,36 @@ func Test_substitute_expr_cpo()
   delfunc XSubExpr
 endfunc
 
+" Lines changed by ":s" are saved for undo together
+func Test_substitute_undo_many_lines()
+  new
+  let lines = map(range(1, 500), '"line " .. v:val')
+  call setline(1, lines)
+  let &undolevels = &undolevels
+  %s/line/LINE/
+  call assert_equal('LINE 1', getline(1))
+  call assert_equal('LINE 500', getline(500))
+  undo
+  call assert_equal(lines, getline(1, '$'))
+  redo
+  call assert_equal(map(copy(lines), 'toupper(v:val[0 : 3]) .. v:val[4 :]'),
+        \ getline(1, '$'))
+  undo
+
+  " a line break in between, lines with and without a match
+  %s/^line \(\d*0\)$/\1\rX/
+  call assert_equal(550, line('$'))
+  call assert_equal(['10', 'X', 'line 11'], getline(10, 12))
+  undo
+  call assert_equal(lines, getline(1, '$'))
+
+  " only some lines match
+  4,300s/1/one/g
+  call assert_equal('line one2one', getline(121))
+  call assert_equal('line 301', getline(301))
+  undo
+  call assert_equal(lines, getline(1, '$'))
+  bwipe!
+endfunc
+
 " vim: shiftwidth=2 sts=2 expandtab
@@ -119,6 +119,7 @@ func Test_syntime()
   call assert_match('^  TOTAL *COUNT *MATCH *SLOWEST *AVERAGE *NAME *PATTERN', a)
   call assert_match(' \d*\.\d* \+[^0]\d* .* cppRawString ', a)
   call assert_match(' \d*\.\d* \+[^0]\d* .* cppNumber ', a)
+  call assert_match('Line start state: [1-9]\d* from previous line, \d\+ from saved state, [1-9]\d* synced, \d\+ lines parsed', a)
 
   syntime off
   syntime clear
@@ -137,6 +138,52 @@ func Test_syntime()
   bd
 endfunc
 
+" Saved syntax states are used again after reloading the buffer.
+func Test_syntime_states_after_reload()
+  CheckFeature profile
+  syntax on
+  let lines = ['/*'] + repeat(['x'], 300) + ['*/', 'int y;']
+  call writefile(lines, 'Xsynreload.c', 'D')
+  new Xsynreload.c
+  setlocal autoread
+  normal! G
+  redraw
+
+  " Append a line, the saved states are still valid.
+  call writefile(lines + ['int z;'], 'Xsynreload.c')
+  checktime
+  call assert_equal('int z;', getline('$'))
+  syntime on
+  syntime clear
+  redraw
+  call assert_match(' [1-9]\d* from saved state, 0 synced,',
+	\ execute('syntime report'))
+  call assert_equal('cComment', synIDattr(synID(line('$') - 5, 1, 1), 'name'))
+
+  " A modeline changes 'iskeyword', the saved states can't be used.
+  setlocal modeline
+  call writefile(lines + ['int z;', '/* vim: set isk+=$ : */'], 'Xsynreload.c')
+  checktime
+  call assert_match('\$', &l:isk)
+  syntime clear
+  redraw
+  call assert_match(' 0 from saved state, [1-9]\d* synced,',
+	\ execute('syntime report'))
+
+  " Change the first line, the saved states can't be used.
+  call writefile(['int x;'] + lines[1:], 'Xsynreload.c')
+  checktime
+  syntime clear
+  redraw
+  call assert_match(' 0 from saved state, [1-9]\d* synced,',
+	\ execute('syntime report'))
+  call assert_equal('cType', synIDattr(synID(line('$'), 1, 1), 'name'))
+  call assert_equal('', synIDattr(synID(line('$') - 5, 1, 1), 'name'))
+
+  syntime off
+  bwipe!
+endfunc
+
 func Test_syntime_completion()
   CheckFeature profile
 
@@ -947,6 +994,51 @@ func Test_syn_contained_transparent()
   bw!
 endfunc
 
+" Matches found in a line are used again when going to a later column.
+func Test_syn_match_same_line()
+  syntax on
+  new
+  syntax match Type /a\+/
+  syntax match Label /b/
+  syntax match Todo /x\zsz/
+  syntax match Error /yl/lc=1
+
+  let [A, B, Z, L] = ['Type', 'Label', 'Todo', 'Error']
+  call setline(1, "aabaxzbzaa ylyl")
+  eval AssertHighlightGroups(1, 1,
+	\ [A, A, B, A, '', Z, B, '', A, A, '', '', L, '', L], 0)
+  call setline(1, "babxzaxz ab")
+  eval AssertHighlightGroups(1, 1,
+	\ [B, A, B, '', Z, A, '', Z, '', A, B], 0)
+  syntax clear
+  bw!
+endfunc
+
+" While waiting for a character syntax is parsed below the window.
+func Test_syntax_parse_ahead()
+  CheckFeature profile
+  CheckFeature timers
+  syntax on
+  new
+  call setline(1, repeat(['xxx'], 500))
+  syntax match Type /x\+/
+  redraw
+  syntime on
+  syntime clear
+  call assert_notmatch(' Type ', execute('syntime report'))
+
+  " Parsing is done while Insert mode waits for a character, a timer ends
+  " Insert mode.
+  call timer_start(200, {-> feedkeys("\<Esc>")})
+  call feedkeys('i', 'xt!')
+  call assert_match(' \d*\.\d* \+[^0]\d* .* Type ', execute('syntime report'))
+  call assert_equal('Type', synIDattr(synID(450, 1, 1), 'name'))
+
+  syntime off
+  syntax clear
+  bw!
+endfunc
+
 func Test_syn_include_contains_TOP()
   let l:case = "TOP in included syntax refers to top level of that included syntax"
   new
@@ -439,6 +439,74 @@ func Test_undofile_earlier()
   call delete('Xundofile')
 endfunc
 
+" Check that an undo tree with branches is restored from an undo file.
+func Test_undofile_branches()
+  new
+  call setline(1, range(1, 20))
+  set ul=100
+  for i in range(1, 20)
+    call setline(i, 'one ' .. i)
+    set ul=100
+  endfor
+  undo 10
+  for i in range(1, 10)
+    call setline(i, 'two ' .. i)
+    set ul=100
+  endfor
+  undo 25
+  let lines25 = getline(1, '$')
+  undo 3
+  let lines3 = getline(1, '$')
+  undo 15
+  let tree = undotree()
+  wundo Xundobranches
+  let lines = getline(1, '$')
+  enew!
+  call setline(1, lines)
+  rundo Xundobranches
+  call assert_equal(tree, undotree())
+  undo 25
+  call assert_equal(lines25, getline(1, '$'))
+  undo 3
+  call assert_equal(lines3, getline(1, '$'))
+
+  bwipe!
+  call delete('Xundobranches')
+endfunc
+
+" Check undo and redo of a substitute in many lines, where some lines do not
+" match and some lines are split.
+func Test_undo_substitute_many_lines()
+  new
+  let lines = map(range(1, 300), {i, v -> v % 7 == 0 ? 'skip ' .. v : 'a ' .. v})
+  call setline(1, lines)
+  set ul=100
+  %s/^a \(\d*5\)$/a\r\1/e
+  set ul=100
+  %s/^a/b/
+  set ul=100
+  let changed = getline(1, '$')
+  call assert_notequal(lines, changed)
+  undo
+  undo
+  call assert_equal(lines, getline(1, '$'))
+  redo
+  redo
+  call assert_equal(changed, getline(1, '$'))
+
+  " also after writing and reading the undo file
+  wundo Xundosubst
+  enew!
+  call setline(1, changed)
+  rundo Xundosubst
+  undo
+  undo
+  call assert_equal(lines, getline(1, '$'))
+
+  bwipe!
+  call delete('Xundosubst')
+endfunc
+
 func Test_wundo_errors()
   new
   call setline(1, 'hello')
@@ -277,6 +277,7 @@ inchar_loop(
     int		did_start_blocking = FALSE;
     long	wait_time;
     long	elapsed_time = 0;
+    int		parse_ahead = FALSE;
 # ifdef ELAPSED_FUNC
     elapsed_T	start_tv;
 
@@ -378,6 +379,15 @@ inchar_loop(
 	    wait_time = 100L;
 # endif
 
+# if defined(FEAT_SYN_HL) && defined(FEAT_RELTIME)
+	// While waiting for the user to type use the time to parse syntax
+	// below the displayed lines.  When there is more to do only check for
+	// a character without waiting.
+	parse_ahead = wtime < 0 && !input_available() && syn_parse_ahead();
+	if (parse_ahead)
+	    wait_time = 0L;
+# endif
+
 	// Wait for a character to be typed or another event, such as the winch
 	// signal or an event on the monitored file descriptors.
 	did_call_wait_func = TRUE;
@@ -425,6 +435,7 @@ inchar_loop(
 		|| interrupted
 # endif
 		|| wait_time > 0
+		|| parse_ahead
 		|| (wtime < 0 && !did_start_blocking))
 	    // no character available, but something to be done, keep going
 	    continue;
@@ -81,8 +81,8 @@
 #define UH_MAGIC 0x18dade	// value for uh_magic when in use
 #define UE_MAGIC 0xabc123	// value for ue_magic when in use
 
-// Size of buffer used for encryption.
-#define CRYPT_BUF_SIZE 8192
+// Size of buffer used for encryption and for reading.
+#define UNDO_BUF_SIZE 8192
 
 #include "vim.h"
 
@@ -93,16 +93,17 @@ typedef struct {
     FILE	*bi_fp;
 #ifdef FEAT_CRYPT
     cryptstate_T *bi_state;
-    char_u	*bi_buffer; // CRYPT_BUF_SIZE, NULL when not buffering
+#endif
+    char_u	*bi_buffer; // UNDO_BUF_SIZE, NULL when not buffering
     size_t	bi_used;    // bytes written to/read from bi_buffer
     size_t	bi_avail;   // bytes available in bi_buffer
-#endif
 } bufinfo_T;
 
 
 static void u_unch_branch(u_header_T *uhp);
 static u_entry_T *u_get_headentry(void);
 static void u_getbot(void);
+static void u_merge_entries(u_header_T *uhp);
 static void u_doit(int count);
 static void u_undoredo(int undo);
 static void u_undo_end(int did_undo, int absolute);
@@ -123,6 +124,7 @@ static void serialize_visualinfo(bufinfo_T *bi, visualinfo_T *info);
 static void unserialize_visualinfo(bufinfo_T *bi, visualinfo_T *info);
 #endif
 static void u_saveline(linenr_T lnum);
+static int u_save_line(undoline_T *ul, linenr_T lnum);
 static void u_blockfree(buf_T *buf);
 
 #define U_ALLOC_LINE(size) lalloc(size, FALSE)
@@ -275,6 +277,112 @@ u_savesub(linenr_T lnum)
     return (u_savecommon(lnum - 1, lnum + 1, lnum + 1, FALSE));
 }
 
+/*
+ * Return TRUE when lines can still be added to the entry of "ub": it is the
+ * first entry of the current undo header and nothing else changed.
+ */
+    static int
+u_batch_valid(u_batch_T *ub)
+{
+    return ub->ub_entry != NULL
+	    && ub->ub_buf == curbuf
+	    && curbuf->b_u_newhead != NULL
+	    && curbuf->b_u_newhead->uh_entry == ub->ub_entry
+	    && !curbuf->b_u_synced
+	    && ub->ub_lcount == curbuf->b_ml.ml_line_count;
+}
+
+/*
+ * Like u_savesub(), for a command that replaces lines one by one, going
+ * down, without changing the number of lines (used by ":s").
+ * When "lnum" is just below the lines saved with the previous call and
+ * nothing else was saved in between, the line is added to the same entry
+ * instead of creating a new entry for every line.  That is a lot faster to
+ * save and to undo when many lines are changed.
+ * "ub" must be cleared before the first call.
+ * Returns FAIL when lines could not be saved, OK otherwise.
+ */
+    int
+u_savesub_batch(linenr_T lnum, u_batch_T *ub)
+{
+    u_entry_T	*uep = ub->ub_entry;
+    undoline_T	*array;
+
+    if (undo_off)
+	return OK;
+
+    if (u_batch_valid(ub)
+	    && lnum > uep->ue_top && lnum <= uep->ue_bot
+#ifdef FEAT_NETBEANS_INTG
+	    && !netbeans_active()
+#endif
+	    && undo_allowed())
+    {
+	// Saved already.
+	if (lnum < uep->ue_bot)
+	    return OK;
+
+	if (uep->ue_size == ub->ub_alloc)
+	{
+	    array = vim_realloc(uep->ue_array,
+				    sizeof(undoline_T) * ub->ub_alloc * 2);
+	    if (array != NULL)
+	    {
+		uep->ue_array = array;
+		ub->ub_alloc *= 2;
+	    }
+	}
+	if (uep->ue_size < ub->ub_alloc
+		&& u_save_line(&uep->ue_array[uep->ue_size], lnum) == OK)
+	{
+	    ++uep->ue_size;
+	    ++uep->ue_bot;
+	    return OK;
+	}
+    }
+
+    ub->ub_entry = NULL;
+    if (u_savesub(lnum) == FAIL)
+	return FAIL;
+
+    // Lines below this one can be added to the new entry.
+    if (curbuf->b_u_newhead != NULL)
+    {
+	uep = curbuf->b_u_newhead->uh_entry;
+	if (uep != NULL && uep->ue_size == 1 && uep->ue_top == lnum - 1
+						   && uep->ue_bot == lnum + 1)
+	{
+	    ub->ub_buf = curbuf;
+	    ub->ub_entry = uep;
+	    ub->ub_alloc = 1;
+	    ub->ub_lcount = curbuf->b_ml.ml_line_count;
+	}
+    }
+    return OK;
+}
+
+/*
+ * Called when done with u_savesub_batch() calls for "ub".  The array of the
+ * entry grows by doubling, free the unused part.
+ */
+    void
+u_savesub_batch_end(u_batch_T *ub)
+{
+    u_entry_T	*uep = ub->ub_entry;
+    undoline_T	*array;
+
+    if (u_batch_valid(ub) && uep->ue_size < ub->ub_alloc)
+    {
+	array = vim_realloc(uep->ue_array, sizeof(undoline_T) * uep->ue_size);
+	if (array != NULL)
+	{
+	    uep->ue_array = array;
+	    ub->ub_alloc = uep->ue_size;
+	}
+    }
+    ub->ub_entry = NULL;
+}
+
 /*
  * A new line is inserted before line "lnum" (used by :s command).
  * The line is inserted, so the new bottom line is lnum + 1.
@@ -926,14 +1034,14 @@ undo_write(bufinfo_T *bi, char_u *ptr, size_t len)
 	size_t	len_todo = len;
 	char_u  *p = ptr;
 
-	while (bi->bi_used + len_todo >= CRYPT_BUF_SIZE)
+	while (bi->bi_used + len_todo >= UNDO_BUF_SIZE)
 	{
-	    size_t	n = CRYPT_BUF_SIZE - bi->bi_used;
+	    size_t	n = UNDO_BUF_SIZE - bi->bi_used;
 
 	    mch_memmove(bi->bi_buffer + bi->bi_used, p, n);
 	    len_todo -= n;
 	    p += n;
-	    bi->bi_used = CRYPT_BUF_SIZE;
+	    bi->bi_used = UNDO_BUF_SIZE;
 	    if (undo_flush(bi) == FAIL)
 		return FAIL;
 	}
@@ -1032,7 +1140,6 @@ put_header_ptr(bufinfo_T *bi, u_header_T *uhp)
     static int
 undo_read_4c(bufinfo_T *bi)
 {
-# ifdef FEAT_CRYPT
     if (bi->bi_buffer != NULL)
     {
 	char_u  buf[4];
@@ -1042,14 +1149,12 @@ undo_read_4c(bufinfo_T *bi)
 	n = ((unsigned)buf[0] << 24) + (buf[1] << 16) + (buf[2] << 8) + buf[3];
 	return n;
     }
-# endif
     return get4c(bi->bi_fp);
 }
 
     static int
 undo_read_2c(bufinfo_T *bi)
 {
-# ifdef FEAT_CRYPT
     if (bi->bi_buffer != NULL)
     {
 	char_u  buf[2];
@@ -1059,14 +1164,12 @@ undo_read_2c(bufinfo_T *bi)
 	n = (buf[0] << 8) + buf[1];
 	return n;
     }
-# endif
     return get2c(bi->bi_fp);
 }
 
     static int
 undo_read_byte(bufinfo_T *bi)
 {
-# ifdef FEAT_CRYPT
     if (bi->bi_buffer != NULL)
     {
 	char_u  buf[1];
@@ -1074,14 +1177,12 @@ undo_read_byte(bufinfo_T *bi)
 	undo_read(bi, buf, (size_t)1);
 	return buf[0];
     }
-# endif
     return getc(bi->bi_fp);
 }
 
     static time_t
 undo_read_time(bufinfo_T *bi)
 {
-# ifdef FEAT_CRYPT
     if (bi->bi_buffer != NULL)
     {
 	char_u  buf[8];
@@ -1093,7 +1194,6 @@ undo_read_time(bufinfo_T *bi)
 	    n = (n << 8) + buf[i];
 	return n;
     }
-# endif
     return get8ctime(bi->bi_fp);
 }
 
@@ -1106,7 +1206,6 @@ undo_read(bufinfo_T *bi, char_u *buffer, size_t size)
 {
     int retval = OK;
 
-# ifdef FEAT_CRYPT
     if (bi->bi_buffer != NULL)
     {
 	int	size_todo = (int)size;
@@ -1118,7 +1217,7 @@ undo_read(bufinfo_T *bi, char_u *buffer, size_t size)
 
 	    if (bi->bi_used >= bi->bi_avail)
 	    {
-		n = fread(bi->bi_buffer, 1, (size_t)CRYPT_BUF_SIZE, bi->bi_fp);
+		n = fread(bi->bi_buffer, 1, (size_t)UNDO_BUF_SIZE, bi->bi_fp);
 		if (n == 0)
 		{
 		    retval = FAIL;
@@ -1126,7 +1225,11 @@ undo_read(bufinfo_T *bi, char_u *buffer, size_t size)
 		}
 		bi->bi_avail = n;
 		bi->bi_used = 0;
-		crypt_decode_inplace(bi->bi_state, bi->bi_buffer, bi->bi_avail, FALSE);
+# ifdef FEAT_CRYPT
+		if (bi->bi_state != NULL)
+		    crypt_decode_inplace(bi->bi_state, bi->bi_buffer,
+							bi->bi_avail, FALSE);
+# endif
 	    }
 	    n = size_todo;
 	    if (n > bi->bi_avail - bi->bi_used)
@@ -1137,9 +1240,7 @@ undo_read(bufinfo_T *bi, char_u *buffer, size_t size)
 	    p += n;
 	}
     }
-    else
-# endif
-    if (fread(buffer, size, 1, bi->bi_fp) != 1)
+    else if (fread(buffer, size, 1, bi->bi_fp) != 1)
 	retval = FAIL;
 
     if (retval == FAIL)
@@ -1218,7 +1319,7 @@ serialize_header(bufinfo_T *bi, char_u *hash)
 
 	if (crypt_whole_undofile(crypt_get_method_nr(buf)))
 	{
-	    bi->bi_buffer = alloc(CRYPT_BUF_SIZE);
+	    bi->bi_buffer = alloc(UNDO_BUF_SIZE);
 	    if (bi->bi_buffer == NULL)
 	    {
 		crypt_free_state(bi->bi_state);
@@ -1810,12 +1911,49 @@ theend:
 # ifdef FEAT_CRYPT
     if (bi.bi_state != NULL)
 	crypt_free_state(bi.bi_state);
-    vim_free(bi.bi_buffer);
 # endif
+    vim_free(bi.bi_buffer);
     if (file_name != name)
 	vim_free(file_name);
 }
 
+/*
+ * Compare the sequence numbers of two undo headers, for qsort().
+ */
+    static int
+uhp_seq_compare(const void *s1, const void *s2)
+{
+    long seq1 = (*(u_header_T **)s1)->uh_seq;
+    long seq2 = (*(u_header_T **)s2)->uh_seq;
+
+    return seq1 == seq2 ? 0 : seq1 > seq2 ? 1 : -1;
+}
+
+/*
+ * Find the header with sequence number "seq" in "uhp_table[num_head]", which
+ * is sorted on sequence number.
+ * Returns the index or -1 when not found.
+ */
+    static long
+uhp_table_find(u_header_T **uhp_table, long num_head, long seq)
+{
+    long    lo = 0;
+    long    hi = num_head - 1;
+    long    mid;
+
+    while (lo <= hi)
+    {
+	mid = lo + (hi - lo) / 2;
+	if (uhp_table[mid]->uh_seq == seq)
+	    return mid;
+	if (uhp_table[mid]->uh_seq < seq)
+	    lo = mid + 1;
+	else
+	    hi = mid - 1;
+    }
+    return -1;
+}
+
 /*
  * Load the undo tree from an undo file.
  * If "name" is not NULL use it as the undo file name.  This also means being
@@ -1932,7 +2070,7 @@ u_read_undo(char_u *name, char_u *hash, char_u *orig_name UNUSED)
 	}
 	if (crypt_whole_undofile(bi.bi_state->method_nr))
 	{
-	    bi.bi_buffer = alloc(CRYPT_BUF_SIZE);
+	    bi.bi_buffer = alloc(UNDO_BUF_SIZE);
 	    if (bi.bi_buffer == NULL)
 	    {
 		crypt_free_state(bi.bi_state);
@@ -1953,6 +2091,16 @@ u_read_undo(char_u *name, char_u *hash, char_u *orig_name UNUSED)
 	goto error;
     }
 
+    // Read the rest of the file through a buffer, reading it in small pieces
+    // is slow.  Not when each piece of text is decrypted separately.  Without
+    // the buffer it still works, only slower.
+    if (bi.bi_buffer == NULL
+# ifdef FEAT_CRYPT
+	    && bi.bi_state == NULL
+# endif
+       )
+	bi.bi_buffer = alloc(UNDO_BUF_SIZE);
+
     if (undo_read(&bi, read_hash, (size_t)UNDO_HASH_SIZE) == FAIL)
     {
 	corruption_error("hash", file_name);
@@ -2066,53 +2214,54 @@ u_read_undo(char_u *name, char_u *hash, char_u *orig_name UNUSED)
 #  define SET_FLAG(j)
 # endif
 
-    // We have put all of the headers into a table. Now we iterate through the
-    // table and swizzle each sequence number we have stored in uh_*_seq into
-    // a pointer corresponding to the header with that sequence number.
+    // We have put all of the headers into a table. Sort it on sequence
+    // number, so that a header can be found quickly.
+    if (num_head > 1)
+	qsort(uhp_table, (size_t)num_head, sizeof(u_header_T *),
+							     uhp_seq_compare);
+    for (i = 1; i < num_head; i++)
+	if (uhp_table[i - 1]->uh_seq == uhp_table[i]->uh_seq)
+	{
+	    corruption_error("duplicate uh_seq", file_name);
+	    goto error;
+	}
+
+    // Now we iterate through the table and swizzle each sequence number we
+    // have stored in uh_*_seq into a pointer corresponding to the header with
+    // that sequence number.
     for (i = 0; i < num_head; i++)
     {
 	uhp = uhp_table[i];
-	if (uhp == NULL)
-	    continue;
-	for (j = 0; j < num_head; j++)
-	    if (uhp_table[j] != NULL && i != j
-			      && uhp_table[i]->uh_seq == uhp_table[j]->uh_seq)
-	    {
-		corruption_error("duplicate uh_seq", file_name);
-		goto error;
-	    }
-	for (j = 0; j < num_head; j++)
-	    if (uhp_table[j] != NULL
-				  && uhp_table[j]->uh_seq == uhp->uh_next.seq)
-	    {
-		uhp->uh_next.ptr = uhp_table[j];
-		SET_FLAG(j);
-		break;
-	    }
-	for (j = 0; j < num_head; j++)
-	    if (uhp_table[j] != NULL
-				  && uhp_table[j]->uh_seq == uhp->uh_prev.seq)
-	    {
-		uhp->uh_prev.ptr = uhp_table[j];
-		SET_FLAG(j);
-		break;
-	    }
-	for (j = 0; j < num_head; j++)
-	    if (uhp_table[j] != NULL
-			      && uhp_table[j]->uh_seq == uhp->uh_alt_next.seq)
-	    {
-		uhp->uh_alt_next.ptr = uhp_table[j];
-		SET_FLAG(j);
-		break;
-	    }
-	for (j = 0; j < num_head; j++)
-	    if (uhp_table[j] != NULL
-			      && uhp_table[j]->uh_seq == uhp->uh_alt_prev.seq)
-	    {
-		uhp->uh_alt_prev.ptr = uhp_table[j];
-		SET_FLAG(j);
-		break;
-	    }
+	if ((j = uhp_table_find(uhp_table, num_head, uhp->uh_next.seq)) >= 0)
+	{
+	    uhp->uh_next.ptr = uhp_table[j];
+	    SET_FLAG(j);
+	}
+	else
+	    uhp->uh_next.ptr = NULL;
+	if ((j = uhp_table_find(uhp_table, num_head, uhp->uh_prev.seq)) >= 0)
+	{
+	    uhp->uh_prev.ptr = uhp_table[j];
+	    SET_FLAG(j);
+	}
+	else
+	    uhp->uh_prev.ptr = NULL;
+	if ((j = uhp_table_find(uhp_table, num_head,
+						  uhp->uh_alt_next.seq)) >= 0)
+	{
+	    uhp->uh_alt_next.ptr = uhp_table[j];
+	    SET_FLAG(j);
+	}
+	else
+	    uhp->uh_alt_next.ptr = NULL;
+	if ((j = uhp_table_find(uhp_table, num_head,
+						  uhp->uh_alt_prev.seq)) >= 0)
+	{
+	    uhp->uh_alt_prev.ptr = uhp_table[j];
+	    SET_FLAG(j);
+	}
+	else
+	    uhp->uh_alt_prev.ptr = NULL;
 	if (old_header_seq > 0 && old_idx < 0 && uhp->uh_seq == old_header_seq)
 	{
 	    old_idx = i;
@@ -2175,8 +2324,8 @@ theend:
 # ifdef FEAT_CRYPT
     if (bi.bi_state != NULL)
 	crypt_free_state(bi.bi_state);
-    vim_free(bi.bi_buffer);
 # endif
+    vim_free(bi.bi_buffer);
     if (fp != NULL)
 	fclose(fp);
     if (file_name != name)
@@ -2820,9 +2969,11 @@ u_undoredo(int undo)
 		else
 		    ml_append_flags(lnum, uep->ue_array[i].ul_line,
 			     (colnr_T)uep->ue_array[i].ul_len, ML_APPEND_UNDO);
-		vim_free(uep->ue_array[i].ul_line);
+		if (uep->ue_text == NULL)
+		    vim_free(uep->ue_array[i].ul_line);
 	    }
 	    vim_free((char_u *)uep->ue_array);
+	    VIM_CLEAR(uep->ue_text);
 	}
 
 	// adjust marks
@@ -3083,6 +3234,8 @@ u_sync(
     {
 	u_getbot();		    // compute ue_bot of previous u_save
 	curbuf->b_u_curhead = NULL;
+	if (curbuf->b_u_newhead != NULL)
+	    u_merge_entries(curbuf->b_u_newhead);
     }
 }
 
@@ -3356,6 +3509,116 @@ u_getbot(void)
     curbuf->b_u_synced = TRUE;
 }
 
+/*
+ * Return TRUE if undo entry "uep" saves lines that were allocated separately
+ * and the change didn't insert or delete lines.
+ */
+    static int
+u_entry_keeps_count(u_entry_T *uep)
+{
+    return uep->ue_size > 0 && uep->ue_text == NULL
+			&& uep->ue_bot == uep->ue_top + uep->ue_size + 1;
+}
+
+/*
+ * Copy the text of the lines saved in undo entry "uep" into one allocated
+ * block and free the separately allocated lines.  Saves the overhead of
+ * allocating each line.
+ */
+    static void
+u_pack_entry(u_entry_T *uep)
+{
+    long_u	len = 0;
+    char_u	*text;
+    long	i;
+
+    for (i = 0; i < uep->ue_size; ++i)
+	len += uep->ue_array[i].ul_len;
+    text = U_ALLOC_LINE(len);
+    if (text == NULL)
+	return;
+
+    for (i = 0; i < uep->ue_size; ++i)
+    {
+	mch_memmove(text, uep->ue_array[i].ul_line, uep->ue_array[i].ul_len);
+	vim_free(uep->ue_array[i].ul_line);
+	uep->ue_array[i].ul_line = text;
+	text += uep->ue_array[i].ul_len;
+    }
+    uep->ue_text = uep->ue_array[0].ul_line;
+}
+
+/*
+ * Merge the entries of header "uhp" that save adjacent lines into one entry,
+ * when they don't change the number of lines.  A command like ":s" saves each
+ * line separately, using one entry for all of them takes much less memory.
+ * The order of the entries doesn't matter for undo and redo then.
+ * The lines of entries with several lines are packed into one block.
+ */
+    static void
+u_merge_entries(u_header_T *uhp)
+{
+    u_entry_T	*uep;
+    u_entry_T	*last;
+    u_entry_T	*next;
+    u_entry_T	*tofree;
+    undoline_T	*array;
+    long	size;
+
+    for (uep = uhp->uh_entry; uep != NULL; uep = uep->ue_next)
+    {
+	if (!u_entry_keeps_count(uep))
+	    continue;
+
+	// An entry saving the lines just above is usually next in the list.
+	size = uep->ue_size;
+	for (last = uep; (next = last->ue_next) != NULL
+		&& u_entry_keeps_count(next)
+		&& next->ue_top + next->ue_size == last->ue_top; last = next)
+	    size += next->ue_size;
+	if (last == uep)
+	{
+	    if (uep->ue_size > 1)
+		u_pack_entry(uep);
+	    continue;
+	}
+
+	array = U_ALLOC_LINE(sizeof(undoline_T) * size);
+	if (array == NULL)
+	    return;
+
+	// Move the lines into the new array and free the merged entries,
+	// "uep" is kept and becomes the merged entry.
+	next = uep;
+	for (;;)
+	{
+	    mch_memmove(array + (next->ue_top - last->ue_top), next->ue_array,
+					    sizeof(undoline_T) * next->ue_size);
+	    vim_free(next->ue_array);
+	    if (next == last)
+		break;
+	    tofree = next->ue_next;
+	    if (next != uep)
+	    {
+#ifdef U_DEBUG
+		next->ue_magic = 0;
+#endif
+		vim_free(next);
+	    }
+	    next = tofree;
+	}
+	uep->ue_next = last->ue_next;
+	uep->ue_top = last->ue_top;
+	uep->ue_size = size;
+	uep->ue_array = array;
+#ifdef U_DEBUG
+	last->ue_magic = 0;
+#endif
+	vim_free(last);
+	u_pack_entry(uep);
+    }
+}
+
 /*
  * Free one header "uhp" and its entry list and adjust the pointers.
  */
@@ -3464,8 +3727,11 @@ u_freeentries(
     static void
 u_freeentry(u_entry_T *uep, long n)
 {
-    while (n > 0)
-	vim_free(uep->ue_array[--n].ul_line);
+    if (uep->ue_text != NULL)
+	vim_free(uep->ue_text);
+    else
+	while (n > 0)
+	    vim_free(uep->ue_array[--n].ul_line);
     vim_free((char_u *)uep->ue_array);
 #ifdef U_DEBUG
     uep->ue_magic = 0;
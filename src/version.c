@@ -1870,16 +1870,25 @@ list_version(void)
 static void do_intro_line(int row, char_u *mesg, int add_version, int attr);
 static void intro_message(int colon);
 
+/*
+ * Return TRUE when the intro message is to be displayed: not editing a file.
+ */
+    int
+can_show_intro_message(void)
+{
+    return BUFEMPTY()
+	    && curbuf->b_fname == NULL
+	    && firstwin->w_next == NULL
+	    && vim_strchr(p_shm, SHM_INTRO) == NULL;
+}
+
 /*
  * Show the intro message when not editing a file.
  */
     void
 maybe_intro_message(void)
 {
-    if (BUFEMPTY()
-	    && curbuf->b_fname == NULL
-	    && firstwin->w_next == NULL
-	    && vim_strchr(p_shm, SHM_INTRO) == NULL)
+    if (can_show_intro_message())
 	intro_message(FALSE);
 }
 
@@ -963,7 +963,7 @@ extern int (*dyn_libintl_wputenv)(const wchar_t *envstring);
 
 #ifdef FEAT_SYN_HL
 # define SST_MIN_ENTRIES 150	// minimal size for state stack array
-# define SST_MAX_ENTRIES 1000	// maximal size for state stack array
+# define SST_MAX_ENTRIES 4000	// maximal size for state stack array
 # define SST_FIX_STATES	 7	// size of sst_stack[].
 # define SST_DIST	 16	// normal distance between entries
 # define SST_INVALID	((synstate_T *)-1)	// invalid syn_state pointer